@@ -0,0 +1,295 @@
+/***************************************************
+  Host (Linux) stand-in for the Particle application.h
+
+  Class code for host application.
+
+  08-Feb-2016   Dave Gutz   Created
+ ****************************************************/
+#include "application.h"
+
+SerialPort    Serial;
+TimeClass     Time;
+EEPROMClass   EEPROM;
+TwoWire       Wire;
+CloudClass    Particle;
+SystemClass   System;
+
+static unsigned long long hostUs    = 0ULL;               // Virtual clock, us
+static time_t             hostEpoch = 1454112000;         // 30-Jan-2016 00:00 UTC
+static int                hostPins[HOST_PINS];
+static unsigned long      hostSeed  = 1UL;
+static IntervalTimer*     hostTimers[HOST_TIMERS];
+
+
+// Virtual clock
+unsigned long millis(void){return((unsigned long)(hostUs/1000ULL));}
+unsigned long micros(void){return((unsigned long)hostUs);}
+void delay(const unsigned long ms){IntervalTimer::hostRun(hostUs + 1000ULL*ms);}
+void delayMicroseconds(const unsigned long us){IntervalTimer::hostRun(hostUs + us);}
+void hostAdvance(const unsigned long ms){IntervalTimer::hostRun(hostUs + 1000ULL*ms);}
+void hostSetEpoch(const time_t utc){hostEpoch = utc;}
+
+// Pins
+void pinMode(const int pin, const PinMode mode){}
+void digitalWrite(const int pin, const int value){hostPins[pin] = value;}
+int  digitalRead(const int pin){return(hostPins[pin]);}
+int  analogRead(const int pin){return(hostPins[pin]);}
+void hostSetAnalog(const int pin, const int value){hostPins[pin] = value;}
+int  hostDigital(const int pin){return(hostPins[pin]);}
+
+// Small LCG so runs repeat exactly regardless of the C library
+long random(const long hi)
+{
+  if ( hi<=0 ) return(0);
+  hostSeed = hostSeed*1103515245UL + 12345UL;
+  return(long((hostSeed>>16) & 0x7FFFUL) % hi);
+}
+long random(const long lo, const long hi)
+{
+  if ( lo>=hi ) return(lo);
+  return(lo + random(hi-lo));
+}
+void randomSeed(const unsigned int seed){hostSeed = seed;}
+
+
+// class String
+// constructors
+String::String(const int v)
+{
+  char buf[16];
+  snprintf(buf, sizeof(buf), "%d", v);
+  s_ = buf;
+}
+String::String(const unsigned int v)
+{
+  char buf[16];
+  snprintf(buf, sizeof(buf), "%u", v);
+  s_ = buf;
+}
+String::String(const long v)
+{
+  char buf[24];
+  snprintf(buf, sizeof(buf), "%ld", v);
+  s_ = buf;
+}
+String::String(const unsigned long v)
+{
+  char buf[24];
+  snprintf(buf, sizeof(buf), "%lu", v);
+  s_ = buf;
+}
+String::String(const double v, const int decimals)
+{
+  char buf[40];
+  snprintf(buf, sizeof(buf), "%.*f", decimals, v);
+  s_ = buf;
+}
+// functions
+int String::indexOf(const char* t) const
+{
+  size_t i = s_.find(t);
+  return(i==std::string::npos ? -1 : int(i));
+}
+int String::indexOf(const char c) const
+{
+  size_t i = s_.find(c);
+  return(i==std::string::npos ? -1 : int(i));
+}
+String String::substring(const unsigned int from) const
+{
+  if ( from>=s_.length() ) return(String(""));
+  return(String(s_.substr(from)));
+}
+String String::substring(const unsigned int from, const unsigned int to) const
+{
+  if ( from>=to || from>=s_.length() ) return(String(""));
+  return(String(s_.substr(from, to-from)));
+}
+
+
+// class Print
+size_t Print::write(const uint8_t* buf, size_t n)
+{
+  size_t k = 0;
+  while ( n-- ) k += write(*buf++);
+  return(k);
+}
+size_t Print::print(const long v, const int base)
+{
+  if ( base==DEC )
+  {
+    char buf[24];
+    snprintf(buf, sizeof(buf), "%ld", v);
+    return(write(buf));
+  }
+  return(print((unsigned long)v, base));
+}
+size_t Print::print(const unsigned long v, const int base)
+{
+  char buf[72];
+  char *p = buf + sizeof(buf) - 1;
+  unsigned long x = v;
+  int b = (base<2 ? 10 : base);
+  *p = '\0';
+  do
+  {
+    int d = x % b;
+    *--p = d<10 ? '0'+d : 'A'+d-10;
+    x /= b;
+  } while ( x>0 );
+  return(write(p));
+}
+size_t Print::print(const double v, const int decimals)
+{
+  char buf[40];
+  snprintf(buf, sizeof(buf), "%.*f", decimals, v);
+  return(write(buf));
+}
+size_t Print::printf(const char* format, ...)
+{
+  char    buf[512];
+  va_list args;
+  va_start(args, format);
+  int n = vsnprintf(buf, sizeof(buf), format, args);
+  va_end(args);
+  if ( n<0 ) return(0);
+  return(write((const uint8_t*)buf, min((size_t)n, sizeof(buf)-1)));
+}
+
+
+// class SerialPort
+size_t SerialPort::write(uint8_t c)
+{
+  if ( enabled_ ) fputc(c, stdout);
+  return(1);
+}
+size_t SerialPort::write(const uint8_t* buf, size_t n)
+{
+  if ( enabled_ ) fwrite(buf, 1, n, stdout);
+  return(n);
+}
+
+
+// class TimeClass
+time_t TimeClass::now(void)
+{
+  return(hostEpoch + time_t(hostUs/1000000ULL) + time_t(zone_*3600.0));
+}
+struct tm TimeClass::tm_(const time_t t)
+{
+  struct tm r;
+  gmtime_r(&t, &r);
+  return(r);
+}
+
+
+// class EEPROMClass
+// constructors
+EEPROMClass::EEPROMClass(void)
+  : puts_(0UL), writes_(0UL)
+{
+  memset(data_, 0xFF, sizeof(data_));     // Erased flash
+}
+// functions
+void EEPROMClass::write(const int addr, const uint8_t v)
+{
+  if ( addr<0 || addr>=HOST_EEPROM_SIZE ) return;
+  data_[addr] = v;
+  writes_++;
+}
+void EEPROMClass::clear(void)
+{
+  memset(data_, 0xFF, sizeof(data_));
+}
+
+
+// class TwoWire
+// constructors
+TwoWire::TwoWire(void)
+  : speed_(CLOCK_SPEED_100KHZ), dev_(NULL), rxLen_(0), rxPos_(0), transmissions_(0UL), bytes_(0UL)
+{}
+// functions
+void TwoWire::beginTransmission(const uint8_t addr)
+{
+  bytes_++;
+}
+size_t TwoWire::write(const uint8_t v)
+{
+  bytes_++;
+  return(1);
+}
+uint8_t TwoWire::endTransmission(const bool stop)
+{
+  transmissions_++;
+  return(0);
+}
+uint8_t TwoWire::requestFrom(const uint8_t addr, const uint8_t n, const bool stop)
+{
+  uint8_t len = min(n, (uint8_t)sizeof(rxBuf_));
+  rxPos_ = 0;
+  rxLen_ = dev_ ? dev_(addr, rxBuf_, len) : 0;
+  transmissions_++;
+  bytes_ += 1 + rxLen_;
+  return(rxLen_);
+}
+
+
+// class CloudClass
+bool CloudClass::publish(const char* name, const char* data)
+{
+  if ( !connected_ ) return(false);
+  publishes_++;
+  bytes_ += strlen(name) + (data ? strlen(data) : 0);
+  return(true);
+}
+
+
+// class SystemClass
+void SystemClass::hostEvent(const system_event_t event, const int param)
+{
+  if ( handler_ && (events_ & event) ) handler_(event, param);
+}
+
+
+// class IntervalTimer
+// functions
+bool IntervalTimer::begin(void (*isr)(), const unsigned long period, const bool scale)
+{
+  end();
+  for (int i=0; i<HOST_TIMERS; i++)
+  {
+    if ( hostTimers[i] ) continue;
+    hostTimers[i] = this;
+    isr_          = isr;
+    resetPeriod_SIT(period, scale);
+    return(true);
+  }
+  return(false);
+}
+void IntervalTimer::end(void)
+{
+  for (int i=0; i<HOST_TIMERS; i++)
+    if ( hostTimers[i]==this ) hostTimers[i] = NULL;
+  isr_ = NULL;
+}
+// Restart the count, from now
+void IntervalTimer::resetPeriod_SIT(const unsigned long period, const bool scale)
+{
+  period_ = max(scale==hmSec ? 500ULL*period : (unsigned long long)period, 1ULL);
+  due_    = hostUs + period_;
+}
+// Move the clock to until, us, stopping at each callback due on the way, earliest first
+void IntervalTimer::hostRun(const unsigned long long until)
+{
+  while ( true )
+  {
+    IntervalTimer *t = NULL;
+    for (int i=0; i<HOST_TIMERS; i++)
+      if ( hostTimers[i] && hostTimers[i]->due_<=until && (!t || hostTimers[i]->due_<t->due_) ) t = hostTimers[i];
+    if ( !t ) break;
+    hostUs   = t->due_;
+    t->due_ += t->period_;
+    t->isr_();
+  }
+  hostUs = until;
+}
@@ -0,0 +1,310 @@
+/***************************************************
+  Host (Linux) stand-in for the Particle application.h
+
+  Just enough of the Particle firmware API for the thermostat core
+  (mySubs, myFilters, myScheduler, mySensor, myProfiler and the LED
+  backpack driver) and myThermostat.ino itself to compile and run
+  natively:  String, Time, EEPROM, Wire, Serial, Particle, System,
+  IntervalTimer and the pin functions.
+
+  Time is virtual.   millis(), micros() and Time.now() read a clock that
+  only moves when delay() or hostAdvance() is called, so a driver can
+  jump straight to the next deadline and run a simulated day in well
+  under a second.   Timer callbacks run as the clock passes them.   The I2C bus has no devices; transactions are counted
+  and reads come back empty unless a device handler is attached.
+
+  Class code for host application.
+
+  08-Feb-2016   Dave Gutz   Created
+ ****************************************************/
+
+#ifndef _application_H
+#define _application_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <stdarg.h>
+#include <math.h>
+#include <time.h>
+#include <string>
+
+// Wiring macros, after the standard headers so they don't collide with them
+#ifndef min
+  #define min(a,b)  ((a)<(b)?(a):(b))
+#endif
+#ifndef max
+  #define max(a,b)  ((a)>(b)?(a):(b))
+#endif
+#define SYSTEM_THREAD(x)
+#define SYSTEM_MODE(x)
+#define Spark             Particle
+
+typedef bool              boolean;
+typedef uint8_t           byte;
+
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+
+enum PinMode {INPUT, OUTPUT, INPUT_PULLUP, INPUT_PULLDOWN};
+enum Pins {D0, D1, D2, D3, D4, D5, D6, D7, A0, A1, A2, A3, A4, A5, A6, A7, HOST_PINS};
+#define LOW               0
+#define HIGH              1
+#define CLOCK_SPEED_100KHZ  100000
+#define CLOCK_SPEED_400KHZ  400000
+#define MY_DEVICES        0
+#define PRIVATE           1
+
+
+// Virtual clock and host controls
+unsigned long millis(void);
+unsigned long micros(void);
+void          delay(const unsigned long ms);
+void          delayMicroseconds(const unsigned long us);
+void          hostAdvance(const unsigned long ms);    // Move the virtual clock, ms
+void          hostSetEpoch(const time_t utc);         // Unix time at millis()==0, s
+void          hostSetAnalog(const int pin, const int value);
+int           hostDigital(const int pin);
+
+// Pins
+void          pinMode(const int pin, const PinMode mode);
+void          digitalWrite(const int pin, const int value);
+int           digitalRead(const int pin);
+int           analogRead(const int pin);
+
+// Wiring random, [lo, hi)
+long          random(const long hi);
+long          random(const long lo, const long hi);
+void          randomSeed(const unsigned int seed);
+
+
+class String
+{
+public:
+  String(void){};
+  String(const char* s) : s_(s ? s : ""){};
+  String(const std::string& s) : s_(s){};
+  String(const char c) : s_(1, c){};
+  String(const int v);
+  String(const unsigned int v);
+  String(const long v);
+  String(const unsigned long v);
+  String(const double v, const int decimals=2);
+  const char*   c_str(void) const {return(s_.c_str());};
+  unsigned int  length(void) const {return(s_.length());};
+  void          reserve(const unsigned int n){s_.reserve(n);};
+  char          operator[](const unsigned int i) const {return(i<s_.length() ? s_[i] : '\0');};
+  char&         operator[](const unsigned int i){return(s_[i]);};
+  String&       operator+=(const String& r){s_ += r.s_; return(*this);};
+  friend String operator+(const String& l, const String& r){return(String(l.s_ + r.s_));};
+  bool          operator==(const String& r) const {return(s_==r.s_);};
+  bool          operator!=(const String& r) const {return(s_!=r.s_);};
+  bool          operator==(const char* r) const {return(s_==(r ? r : ""));};
+  bool          operator!=(const char* r) const {return(!(*this==r));};
+  int           indexOf(const char* t) const;
+  int           indexOf(const char c) const;
+  String        substring(const unsigned int from) const;
+  String        substring(const unsigned int from, const unsigned int to) const;
+  long          toInt(void) const {return(atol(s_.c_str()));};
+  float         toFloat(void) const {return(atof(s_.c_str()));};
+private:
+  std::string   s_;
+};
+
+
+class Print
+{
+public:
+  virtual ~Print(){};
+  virtual size_t  write(uint8_t c) = 0;
+  virtual size_t  write(const uint8_t* buf, size_t n);
+  size_t          write(const char* s){return(write((const uint8_t*)s, strlen(s)));};
+  size_t          print(const char* s){return(write(s));};
+  size_t          print(const String& s){return(write(s.c_str()));};
+  size_t          print(const char c){return(write((uint8_t)c));};
+  size_t          print(const int v, const int base=DEC){return(print(long(v), base));};
+  size_t          print(const unsigned int v, const int base=DEC){return(print((unsigned long)v, base));};
+  size_t          print(const long v, const int base=DEC);
+  size_t          print(const unsigned long v, const int base=DEC);
+  size_t          print(const double v, const int decimals=2);
+  size_t          println(void){return(write("\r\n"));};
+  template <typename T> size_t println(const T v){size_t n = print(v); return(n+println());};
+  template <typename T> size_t println(const T v, const int f){size_t n = print(v, f); return(n+println());};
+  size_t          printf(const char* format, ...);
+};
+
+
+class SerialPort : public Print
+{
+public:
+  SerialPort(void) : enabled_(true){};
+  void    begin(const long baud){};
+  void    end(void){};
+  void    flush(void){fflush(stdout);};
+  bool    available(void){return(false);};
+  size_t  write(uint8_t c);
+  size_t  write(const uint8_t* buf, size_t n);
+  using Print::write;
+  void    enable(const bool on){enabled_ = on;};   // Host only, silence the port
+private:
+  bool    enabled_;
+};
+extern SerialPort Serial;
+
+
+// Particle time, zone applied by now() as in the Particle firmware
+class TimeClass
+{
+public:
+  TimeClass(void) : zone_(0.0){};
+  void    zone(const float hours){zone_ = hours;};
+  time_t  now(void);
+  int     hour(void){return(hour(now()));};
+  int     hour(const time_t t){return(tm_(t).tm_hour);};
+  int     minute(void){return(minute(now()));};
+  int     minute(const time_t t){return(tm_(t).tm_min);};
+  int     second(const time_t t){return(tm_(t).tm_sec);};
+  int     day(const time_t t){return(tm_(t).tm_mday);};
+  int     weekday(const time_t t){return(tm_(t).tm_wday+1);};  // 1-7, 1 is Sunday
+  int     month(const time_t t){return(tm_(t).tm_mon+1);};     // 1-12
+  int     year(const time_t t){return(tm_(t).tm_year+1900);};
+private:
+  struct tm tm_(const time_t t);
+  float   zone_;      // Hours from zulu
+};
+extern TimeClass Time;
+
+
+// Emulated EEPROM, 2047 bytes as on the Photon
+#define HOST_EEPROM_SIZE  2047
+class EEPROMClass
+{
+public:
+  EEPROMClass(void);
+  uint8_t read(const int addr){return(data_[addr]);};
+  void    write(const int addr, const uint8_t v);
+  template <typename T> T& get(const int addr, T& t)
+  {
+    memcpy((uint8_t*)&t, data_+addr, sizeof(T));
+    return(t);
+  };
+  template <typename T> const T& put(const int addr, const T& t)
+  {
+    const uint8_t* p = (const uint8_t*)&t;
+    for (unsigned i=0; i<sizeof(T); i++) write(addr+i, p[i]);
+    puts_++;
+    return(t);
+  };
+  int     length(void){return(HOST_EEPROM_SIZE);};
+  void    clear(void);
+  unsigned long puts(void){return(puts_);};          // Host only, put() calls
+  unsigned long writes(void){return(writes_);};      // Host only, byte writes
+private:
+  uint8_t       data_[HOST_EEPROM_SIZE];
+  unsigned long puts_;
+  unsigned long writes_;
+};
+extern EEPROMClass EEPROM;
+
+
+// I2C master.   A device handler, if attached, answers requestFrom for its address.
+typedef uint8_t (*HostI2CDevice)(const uint8_t addr, uint8_t* buf, const uint8_t n);
+class TwoWire
+{
+public:
+  TwoWire(void);
+  void    setSpeed(const unsigned long hz){speed_ = hz;};
+  void    begin(void){};
+  void    beginTransmission(const uint8_t addr);
+  size_t  write(const uint8_t v);
+  uint8_t endTransmission(const bool stop=true);
+  uint8_t requestFrom(const uint8_t addr, const uint8_t n, const bool stop=true);
+  int     available(void){return(rxLen_-rxPos_);};
+  int     read(void){return(rxPos_<rxLen_ ? rxBuf_[rxPos_++] : -1);};
+  void    attach(HostI2CDevice dev){dev_ = dev;};             // Host only
+  unsigned long transmissions(void){return(transmissions_);}; // Host only
+  unsigned long bytes(void){return(bytes_);};                 // Host only, incl. address bytes
+private:
+  unsigned long speed_;
+  HostI2CDevice dev_;
+  uint8_t       rxBuf_[32];
+  int           rxLen_;
+  int           rxPos_;
+  unsigned long transmissions_;
+  unsigned long bytes_;
+};
+extern TwoWire Wire;
+
+
+// Cloud.   Never connected; publishes are counted so traffic can be measured.
+typedef int (*CloudFunction)(String);
+typedef void (*EventHandler)(const char*, const char*);
+class CloudClass
+{
+public:
+  CloudClass(void) : connected_(false), publishes_(0UL), bytes_(0UL){};
+  bool    connected(void){return(connected_);};
+  void    connect(void){};
+  void    process(void){};
+  void    syncTime(void){};
+  bool    publish(const char* name, const char* data=NULL);
+  bool    publish(const char* name, const char* data, const int ttl, const int scope){return(publish(name, data));};
+  bool    variable(const char* name, const String& v){return(true);};
+  bool    variable(const char* name, const int& v){return(true);};
+  bool    variable(const char* name, const double& v){return(true);};
+  bool    function(const char* name, CloudFunction f){return(true);};
+  bool    subscribe(const char* name, EventHandler h, const int scope=0){return(true);};
+  void    hostConnect(const bool on){connected_ = on;};        // Host only
+  unsigned long publishes(void){return(publishes_);};         // Host only
+  unsigned long bytes(void){return(bytes_);};                 // Host only, name + data
+private:
+  bool          connected_;
+  unsigned long publishes_;
+  unsigned long bytes_;
+};
+extern CloudClass Particle;
+
+
+// System events.   Handlers are kept;  hostEvent() raises one, as a reset would.
+typedef unsigned long     system_event_t;
+enum SystemEvents {reset=0x01UL, firmware_update=0x02UL};
+typedef void (*SystemEventHandler)(system_event_t event, int param);
+class SystemClass
+{
+public:
+  SystemClass(void) : events_(0UL), handler_(NULL){};
+  bool    on(const system_event_t events, SystemEventHandler h){events_ = events; handler_ = h; return(true);};
+  void    hostEvent(const system_event_t event, const int param=0);   // Host only
+private:
+  system_event_t      events_;
+  SystemEventHandler  handler_;
+};
+extern SystemClass System;
+
+
+// Timer interrupts, in place of SparkIntervalTimer.h.   The callback runs when the
+// virtual clock passes its time, with millis() reading that time.
+#define __INTERVALTIMER_H__
+enum {uSec, hmSec};                         // microseconds or half-milliseconds
+#define HOST_TIMERS       4
+class IntervalTimer
+{
+public:
+  IntervalTimer(void) : isr_(NULL), period_(0ULL), due_(0ULL){};
+  ~IntervalTimer(void){end();};
+  bool    begin(void (*isr)(), const unsigned long period, const bool scale);
+  void    end(void);
+  void    resetPeriod_SIT(const unsigned long period, const bool scale);
+  static void hostRun(const unsigned long long until);  // Host only, callbacks due by until, us
+private:
+  void                (*isr_)();
+  unsigned long long  period_;    // us
+  unsigned long long  due_;       // us
+};
+
+
+#endif
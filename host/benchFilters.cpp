@@ -0,0 +1,103 @@
+/* benchFilters.cpp
+  Per-sample cost of the rate-lag filters:  the virtual RateLagExp of
+  myFilters.h called through a base pointer, as setup() used to build it
+  with new, against the RateLagExpT templates of myFilterTemplates.h with
+  run-time and compile-time coefficients.   Outputs are checked against
+  the virtual version.
+
+  Usage:  benchFilters [samples]
+
+  10-Feb-2016   Dave Gutz   Created
+*/
+
+#include <chrono>
+#include "application.h"
+#include "mySubs.h"
+#include "myFilters.h"
+
+static const double T   = 5.0;      // FILTER_DELAY, s
+static const double tau = RATE_TAU; // myThermostat.ino
+constexpr RateLagExpCoeff<double> kD(5.0, RATE_TAU);
+constexpr RateLagExpCoeff<float>  kF(5.0f, float(RATE_TAU));
+
+// Sensed temperature:  slow ramp, heater ripple and sensor noise
+static double sample(const unsigned long i)
+{
+  return(68.0 + 1e-4*double(i%20000) + 0.2*sin(double(i)*0.01) + 0.01*double(random(-10, 10)));
+}
+
+typedef std::chrono::steady_clock Clock;
+static double nsPer(const Clock::time_point t0, const unsigned long n)
+{
+  return(std::chrono::duration<double, std::nano>(Clock::now() - t0).count()/double(n));
+}
+
+int main(int argc, char** argv)
+{
+  unsigned long n = argc>1 ? strtoul(argv[1], NULL, 10) : 10000000UL;
+  double* in  = new double[n];
+  double* ref = new double[n];
+  for (unsigned long i=0; i<n; i++) in[i] = sample(i);
+  memset(ref, 0, n*sizeof(double));     // Fault the pages in before timing
+
+  // Virtual, heap allocated.   The volatile read hides the dynamic type from the optimizer.
+  RateLagExp* volatile pv = new RateLagExp(T, tau, -0.1, 0.1);
+  DiscreteFilter*      pb = pv;
+  RateLagExp*          pe = pv;
+  Clock::time_point t0 = Clock::now();
+  ref[0] = pb->calculate(in[0], 1);
+  for (unsigned long i=1; i<n; i++) ref[i] = pb->calculate(in[i], 0);
+  double nsVirt = nsPer(t0, n);
+
+  double sumVT = 0.0;
+  t0 = Clock::now();
+  sumVT += pe->calculate(in[0], 1, T);
+  for (unsigned long i=1; i<n; i++) sumVT += pe->calculate(in[i], 0, T);
+  double nsVirtT = nsPer(t0, n);
+
+  // Templates
+  RateLagExpT<double, VARIABLE_STEP> fv(T, tau, -0.1, 0.1);
+  double sumTV = 0.0;
+  t0 = Clock::now();
+  sumTV += fv.calculate(in[0], 1, T);
+  for (unsigned long i=1; i<n; i++) sumTV += fv.calculate(in[i], 0, T);
+  double nsTmplT = nsPer(t0, n);
+
+  RateLagExpT<double> fd(kD, -0.1, 0.1);
+  double errD = 0.0;
+  t0 = Clock::now();
+  double out = fd.calculate(in[0], 1);
+  errD = fabs(out-ref[0]);
+  for (unsigned long i=1; i<n; i++)
+  {
+    out  = fd.calculate(in[i], 0);
+    errD = max(errD, fabs(out-ref[i]));
+  }
+  double nsTmplD = nsPer(t0, n);
+
+  RateLagExpT<float> ff(kF, -0.1f, 0.1f);
+  double errF = 0.0;
+  t0 = Clock::now();
+  float outF = ff.calculate(float(in[0]), 1);
+  errF = fabs(outF-ref[0]);
+  for (unsigned long i=1; i<n; i++)
+  {
+    outF = ff.calculate(float(in[i]), 0);
+    errF = max(errF, fabs(outF-ref[i]));
+  }
+  double nsTmplF = nsPer(t0, n);
+
+  Serial.printf("filters: %lu samples, ns/sample\n", n);
+  Serial.printf("  virtual RateLagExp, fixed T          %7.2f\n", nsVirt);
+  Serial.printf("  virtual RateLagExp, variable T       %7.2f   (sum diff %g)\n", nsVirtT, sumVT-sumTV);
+  Serial.printf("  RateLagExpT<double, VARIABLE_STEP>   %7.2f\n", nsTmplT);
+  Serial.printf("  RateLagExpT<double> constexpr coeff  %7.2f   max |rate err| %g\n", nsTmplD, errD);
+  Serial.printf("  RateLagExpT<float>  constexpr coeff  %7.2f   max |rate err| %g\n", nsTmplF, errF);
+  Serial.printf("  coefficients  a=%.17g b=%.17g c=%.17g (constexpr)\n", kD.a, kD.b, kD.c);
+  double eTt = exp(-T/tau);
+  Serial.printf("                a=%.17g b=%.17g c=%.17g (libm)\n", tau/T - eTt/(1-eTt), 1.0/(1-eTt) - tau/T, (1.0-eTt)/T);
+  delete pv;
+  delete[] in;
+  delete[] ref;
+  return(0);
+}
@@ -0,0 +1,69 @@
+/* benchHouse.cpp
+  Accuracy and cost of the HouseHeat integration methods against step size.
+  The bare-Photon house is driven for a week by a heat call of 20 minutes
+  in every hour, against a reference of EULER at 0.05 s.   Errors are the
+  largest difference in air temperature, sampled every 20 minutes.
+
+  Usage:  benchHouse [days [OAT]]
+
+  12-Feb-2016   Dave Gutz   Created
+*/
+
+#include <chrono>
+#include "application.h"
+#include "mySubs.h"
+
+#define SAMPLE  1200.0      // Comparison interval, s
+
+typedef std::chrono::steady_clock Clock;
+
+static double duty(const double t)
+{
+  return(fmod(t, 3600.0)<1200.0 ? 1.0 : 0.0);
+}
+
+// Air temperature every SAMPLE
+static double run(const Integration integ, const double T, const double days, const double OAT,
+  double* Ta, double* ns)
+{
+  HouseHeat house("house", HOUSE_HEAT);
+  house.integration(integ);
+  unsigned long steps = (unsigned long)(days*86400.0/T + 0.5);
+  unsigned long every = (unsigned long)(SAMPLE/T + 0.5);
+  Clock::time_point t0 = Clock::now();
+  house.update(true, T, NOMSET, duty(0), 0, OAT);
+  for (unsigned long i=1; i<steps; i++)
+  {
+    if ( i%every==0 ) Ta[i/every] = house.Ta();
+    house.update(false, T, NOMSET, duty(double(i)*T), 0, OAT);
+  }
+  *ns = std::chrono::duration<double, std::nano>(Clock::now() - t0).count()/double(steps);
+  return(steps);
+}
+
+int main(int argc, char** argv)
+{
+  double days = argc>1 ? atof(argv[1]) : 7.0;
+  double OAT  = argc>2 ? atof(argv[2]) : 30.0;
+  unsigned long n = (unsigned long)(days*86400.0/SAMPLE);
+  double* ref = new double[n+1];
+  double* Ta  = new double[n+1];
+  double  ns;
+  run(EULER, 0.05, days, OAT, ref, &ns);
+
+  Serial.printf("house: %4.1f days at OAT=%4.1f, max |Ta err| vs EULER at 0.05 s\n", days, OAT);
+  const double Ts[] = {5, 60, 300, 1200};
+  for (int m=0; m<2; m++)
+    for (unsigned t=0; t<sizeof(Ts)/sizeof(double); t++)
+  {
+    Integration integ = m==0 ? EULER : EXACT;
+    double steps = run(integ, Ts[t], days, OAT, Ta, &ns);
+    double err = 0.0;
+    for (unsigned long i=1; i<n; i++) err = max(err, fabs(Ta[i]-ref[i]));
+    Serial.printf("  %-5s T=%6.0f s  %8.0f updates  %6.1f ns/update  err %9.2e F\n",
+      integ==EULER ? "EULER" : "EXACT", Ts[t], steps, ns, err);
+  }
+  delete[] ref;
+  delete[] Ta;
+  return(0);
+}
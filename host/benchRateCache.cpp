@@ -0,0 +1,113 @@
+/* benchRateCache.cpp
+  Variable-step rate filter under the update time jitter a real loop puts
+  on the filter task.   Three ways to handle T:
+      nominal   coefficients for the design T, lag integrated with the actual
+                T; what calculate(in, RESET, T) did before the coefficient cache
+      exact     coefficients recomputed with exp() every sample
+      cached    RateLagExpT<double, VARIABLE_STEP>, coefficients by T in ms
+  Rates are compared with exact.   T distributions, ms:
+      steady    FILTER_DELAY every time
+      jitter    FILTER_DELAY + 0..30, loop pass granularity
+      blynk     jitter, and 2% of passes late by up to BLYNK_TIMEOUT_MS
+                while Blynk.run() waits on the network
+
+  Usage:  benchRateCache [samples]
+
+  11-Feb-2016   Dave Gutz   Created
+*/
+
+#include <chrono>
+#include "application.h"
+#include "mySubs.h"
+#include "myFilterTemplates.h"
+
+#define BLYNK_TIMEOUT_MS 2000UL             // As myThermostat.ino
+
+static const double tau = RATE_TAU; // myThermostat.ino
+
+typedef std::chrono::steady_clock Clock;
+static double nsPer(const Clock::time_point t0, const unsigned long n)
+{
+  return(std::chrono::duration<double, std::nano>(Clock::now() - t0).count()/double(n));
+}
+
+// One rate-lag step with coefficients k and lag integration time T
+static double step(const RateLagExpCoeff<double>& k, const double T, const double in, double* rstate, double* lstate)
+{
+  double r = k.c*(k.a*(*rstate) + k.b*in - *lstate);
+  r       = r<0.1 ? r : 0.1;
+  r       = r>-0.1 ? r : -0.1;
+  *rstate = in;
+  *lstate += T*r;
+  return(r);
+}
+
+static void run(const char* name, const double* in, const double* T, const unsigned long n)
+{
+  double* ref = new double[n];
+  memset(ref, 0, n*sizeof(double));     // Fault the pages in before timing
+  double rs, ls;
+
+  // Exact
+  rs = ls = in[0];
+  Clock::time_point t0 = Clock::now();
+  for (unsigned long i=0; i<n; i++)
+    ref[i] = step(RateLagExpCoeff<double>(T[i], tau, exp(-T[i]/tau)), T[i], in[i], &rs, &ls);
+  double nsExact = nsPer(t0, n);
+
+  // Nominal
+  const RateLagExpCoeff<double> kNom(float(FILTER_DELAY)/1000.0, tau, exp(-float(FILTER_DELAY)/1000.0/tau));
+  double errNom = 0.0;
+  rs = ls = in[0];
+  t0 = Clock::now();
+  for (unsigned long i=0; i<n; i++)
+  {
+    double r = step(kNom, T[i], in[i], &rs, &ls);   // max() is a macro
+    errNom   = max(errNom, fabs(r - ref[i]));
+  }
+  double nsNom = nsPer(t0, n);
+
+  // Cached
+  RateLagExpT<double, VARIABLE_STEP> f(float(FILTER_DELAY)/1000.0, tau, -0.1, 0.1);
+  double errCache = 0.0;
+  f.calculate(in[0], 1, T[0]);
+  f.reset(in[0]);
+  t0 = Clock::now();
+  for (unsigned long i=0; i<n; i++)
+  {
+    double r = f.calculate(in[i], 0, T[i]);
+    errCache = max(errCache, fabs(r - ref[i]));
+  }
+  double nsCache = nsPer(t0, n);
+  unsigned long off = f.cacheHits() + f.cacheMisses();
+
+  Serial.printf("  %-7s exact %6.2f  nominal %6.2f (err %8.2e)  cached %6.2f (err %8.2e)  off-design %5.1f%% hit %5.1f%%\n",
+    name, nsExact, nsNom, errNom, nsCache, errCache, 100.0*double(off)/double(n),
+    off ? 100.0*double(f.cacheHits())/double(off) : 100.0);
+  delete[] ref;
+}
+
+int main(int argc, char** argv)
+{
+  unsigned long n = argc>1 ? strtoul(argv[1], NULL, 10) : 2000000UL;
+  double* in  = new double[n];
+  double* T   = new double[n];
+  for (unsigned long i=0; i<n; i++)
+    in[i] = 68.0 + 1e-4*double(i%20000) + 0.2*sin(double(i)*0.01) + 0.01*double(random(-10, 10));
+
+  Serial.printf("rate filter update time jitter:  %lu samples, ns/sample, max |rate err| vs exact, F/s\n", n);
+  for (unsigned long i=0; i<n; i++) T[i] = double(FILTER_DELAY)/1000.0;
+  run("steady", in, T, n);
+  for (unsigned long i=0; i<n; i++) T[i] = double(FILTER_DELAY + random(0, 30))/1000.0;
+  run("jitter", in, T, n);
+  for (unsigned long i=0; i<n; i++)
+  {
+    unsigned long ms = FILTER_DELAY + random(0, 30);
+    if ( random(0, 100)<2 ) ms += random(0, BLYNK_TIMEOUT_MS);
+    T[i] = double(ms)/1000.0;
+  }
+  run("blynk", in, T, n);
+  delete[] in;
+  delete[] T;
+  return(0);
+}
@@ -0,0 +1,81 @@
+/* benchSchedule.cpp
+  Schedule lookup by ScheduleIndex against the linear scan it replaced,
+  on the schedule of myThermostat.ino and on longer generated weeks.
+  Every lookup is checked against the scan, including at the change times
+  themselves.
+
+  Usage:  benchSchedule [lookups]
+
+  15-Feb-2016   Dave Gutz   Created
+*/
+
+#include <chrono>
+#include "application.h"
+#include "mySubs.h"
+
+extern float hourCh[7][NCH];           // myThermostat.ino schedule, in hostStubs.cpp
+extern const float tempCh[7][NCH];
+
+typedef std::chrono::steady_clock Clock;
+static double nsPer(const Clock::time_point t0, const unsigned long n)
+{
+  return(std::chrono::duration<double, std::nano>(Clock::now() - t0).count()/double(n));
+}
+
+// lookupTempScan() generalized to n entries, returns the entry
+static int scan(const float* hours, const int n, const double tim)
+{
+  if ( tim<hours[0] || tim>=hours[n-1] ) return(n-1);
+  int i;
+  for (i=0; i<n; i++) if ( !(tim>hours[i]) ) break;
+  return(i>0 ? i-1 : n-1);
+}
+
+int main(int argc, char** argv)
+{
+  unsigned long n = argc>1 ? strtoul(argv[1], NULL, 10) : 2000000UL;
+  double* tim = new double[n];
+  for (unsigned long i=0; i<n; i++) tim[i] = double(random(0, 7*24*3600))/3600.0;
+  for (int day=0; day<7; day++)
+    for (int num=0; num<NCH; num++) hourCh[day][num] += float(day)*24.0;
+  for (int i=0; i<7*NCH && i<long(n); i++) tim[i] = (&hourCh[0][0])[i];    // Exactly at changes
+
+  // myThermostat.ino schedule, lookupTemp() as used
+  double sum = 0;
+  Clock::time_point t0 = Clock::now();
+  for (unsigned long i=0; i<n; i++) sum += lookupTempScan(tim[i]);
+  double nsScan = nsPer(t0, n);
+  schedIndex.build(&hourCh[0][0], &tempCh[0][0], 7*NCH);
+  double sumI = 0;
+  unsigned long bad = 0;
+  t0 = Clock::now();
+  for (unsigned long i=0; i<n; i++) sumI += lookupTemp(tim[i]);
+  double nsIndex = nsPer(t0, n);
+  for (unsigned long i=0; i<n; i++) if ( lookupTemp(tim[i])!=lookupTempScan(tim[i]) ) bad++;
+  Serial.printf("schedule lookup, %lu lookups, ns/lookup\n", n);
+  Serial.printf("  %3d entries  scan %7.2f  index %6.2f  mismatches %lu\n", 7*NCH, nsScan, nsIndex, bad + (sum!=sumI));
+
+  // Longer schedules:  k changes a day, jittered off the quarter hour
+  const int ks[] = {8, 16, 32};
+  for (unsigned j=0; j<sizeof(ks)/sizeof(int); j++)
+  {
+    int     m = 7*ks[j];
+    float*  hours = new float[m];
+    for (int i=0; i<m; i++) hours[i] = (float(i) + 0.1f + 0.8f*float(random(0, 100))/100.0f)*24.0f/float(ks[j]);
+    ScheduleIndex index;
+    index.build(hours, NULL, m);
+    long sumS = 0, sumX = 0;
+    bad = 0;
+    t0 = Clock::now();
+    for (unsigned long i=0; i<n; i++) sumS += scan(hours, m, tim[i]);
+    nsScan = nsPer(t0, n);
+    t0 = Clock::now();
+    for (unsigned long i=0; i<n; i++) sumX += index.find(tim[i]);
+    nsIndex = nsPer(t0, n);
+    for (unsigned long i=0; i<n; i++) if ( index.find(tim[i])!=scan(hours, m, tim[i]) ) bad++;
+    Serial.printf("  %3d entries  scan %7.2f  index %6.2f  mismatches %lu\n", m, nsScan, nsIndex, bad + (sumS!=sumX));
+    delete[] hours;
+  }
+  delete[] tim;
+  return(0);
+}
@@ -0,0 +1,72 @@
+/* checkPersist.cpp
+  FlashShadow coalescing when the clock moves during a pass, as it does on
+  the Photon:  loop() takes now at the start of the pass, the puts come
+  later in it, and poll(now) at the end must not take them as quiet.   A
+  burst of setting changes and a statlog drain each must cost one commit.
+
+  Usage:  checkPersist         exit status 0 if all pass
+
+  20-Feb-2016   Dave Gutz   Created
+*/
+
+#include "application.h"
+#include "myPersist.h"
+#include "myLog.h"
+#include "mySubs.h"
+
+#define WORK_MS     3UL     // Work in a pass before the put, ms
+#define PASS_MS     100UL   // Pass period, ms
+
+static int failed = 0;
+
+static void check(const char* what, const unsigned long got, const unsigned long want)
+{
+  printf("%-40s %4lu %s\n", what, got, got==want ? "ok" : "FAIL");
+  if ( got!=want ) failed++;
+}
+
+// A pass of loop():  now, work, maybe a put, poll
+static void pass(const int put, const uint8_t v)
+{
+  unsigned long now = millis();
+  hostAdvance(WORK_MS);
+  if ( put ) flashShadow.put(0, v);
+  flashShadow.poll(now);
+  hostAdvance(PASS_MS-WORK_MS);
+}
+
+int main(int argc, char** argv)
+{
+  flashShadow.begin();
+
+  // Six changes a pass apart, then quiet
+  unsigned long c0 = flashShadow.commits();
+  for (int i=0; i<6; i++) pass(1, uint8_t(i+1));
+  check("burst of 6 puts, commits while changing", flashShadow.commits()-c0, 0);
+  for (unsigned long t=0; t<PERSIST_QUIET+2*PASS_MS; t+=PASS_MS) pass(0, 0);
+  check("burst of 6 puts, commits once quiet", flashShadow.commits()-c0, 1);
+
+  // Drain of the offline log, a record delivered every 2 s
+  RingLog log;
+  log.begin();
+  LogRecord r;
+  memset(&r, 0, sizeof(r));
+  for (int i=0; i<8; i++) log.append(r);
+  c0 = flashShadow.commits();
+  int delivered = 0;
+  while ( log.next(&r) )
+  {
+    unsigned long now = millis();
+    hostAdvance(WORK_MS);
+    log.sent();
+    delivered++;
+    flashShadow.poll(now);
+    hostAdvance(2000UL-WORK_MS);
+  }
+  check("drain, records delivered", delivered, 8);
+  check("drain, commits while draining", flashShadow.commits()-c0, 0);
+  for (unsigned long t=0; t<PERSIST_QUIET+2*PASS_MS; t+=PASS_MS) pass(0, 0);
+  check("drain, commits once quiet", flashShadow.commits()-c0, 1);
+
+  return(failed ? 1 : 0);
+}
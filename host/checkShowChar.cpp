@@ -0,0 +1,50 @@
+/* checkShowChar.cpp
+  Adafruit_8x8matrix::showChar(c) against what it stands for, clear(),
+  setCursor(0, 0) and write(c), for characters 1-127 at text sizes 1 and 2
+  and the text colors the sketch and the GFX defaults use.   The frames
+  start from a full one so a missed clear shows.
+
+  Usage:  checkShowChar        exit status 0 if all pass
+
+  20-Feb-2016   Dave Gutz   Created
+*/
+
+#include "application.h"
+#include "mySubs.h"            // and adafruit-led-backpack.h, which has no guard
+
+int main(int argc, char** argv)
+{
+  int failed = 0;
+  for (int color=0; color<2; color++)
+    for (uint8_t size=1; size<=2; size++)
+    {
+      int differ = 0;
+      for (int c=1; c<128; c++)
+      {
+        Adafruit_8x8matrix  fast, drawn;
+        fast.setTextSize(size);
+        drawn.setTextSize(size);
+        if ( color )
+        {
+          fast.setTextColor(LED_ON);
+          drawn.setTextColor(LED_ON);
+        }
+        fast.fillScreen(LED_ON);
+        drawn.fillScreen(LED_ON);
+        fast.showChar(uint8_t(c));
+        drawn.clear();
+        drawn.setCursor(0, 0);
+        drawn.write(uint8_t(c));
+        if ( memcmp(fast.displaybuffer, drawn.displaybuffer, sizeof(fast.displaybuffer))!=0 )
+        {
+          printf("  '%c' (%d) differs\n", c>=' ' ? c : '?', c);
+          differ++;
+        }
+      }
+      char  what[64];
+      snprintf(what, sizeof(what), "size %d, %s, characters differing", size, color ? "LED_ON" : "default color");
+      printf("%-48s %4d %s\n", what, differ, differ ? "FAIL" : "ok");
+      failed += differ;
+    }
+  return(failed ? 1 : 0);
+}
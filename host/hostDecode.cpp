@@ -0,0 +1,121 @@
+/* hostDecode.cpp
+  Turn base64 TelemetryRecord 'stat' payloads (myTelemetry.h) in Particle
+  event captures back into the pipe delimited text, so the .txt in Data/
+  tools and spreadsheets keep working.   Other lines pass through.   With
+  -e the reverse:  text stat records are encoded, to try the binary form
+  on old captures.   Payload sizes are summarized on stderr.
+
+  Usage:  hostDecode [-e] [file...]     stdin if no file, result on stdout
+
+  19-Feb-2016   Dave Gutz   Created
+*/
+
+#include "application.h"
+#include "myReplay.h"
+#include "myTelemetry.h"
+
+static unsigned long  converted = 0UL;  // Records converted
+static double         bytesIn   = 0;    // Their payload sizes before and after
+static double         bytesOut  = 0;
+
+// Text stat as a record, fields absent from it zero.   Version 1 unless it has a window.
+static void encode(const StatRecord& s, TelemetryRecord* t)
+{
+  memset(t, 0, sizeof(*t));
+  t->version  = s.has(STAT_WINDOW) ? TELEM_VERSION : 1;
+  t->flags    = (s.call ? TELEM_CALL : 0) | (s.held ? TELEM_HELD : 0);
+  t->minute   = s.minute;
+  t->set      = telemInt16(s.set, 0.01);
+  t->temp     = telemInt16(s.temp, 0.01);
+  t->tempComp = telemInt16(s.tempc, 0.01);
+  t->tmod     = telemInt16(s.tmod, 0.01);
+  t->oat      = telemInt16(s.oat, 0.1);
+  t->rejh     = telemInt16(s.rejh, 0.001);
+  t->T        = uint16_t(max(min(s.T*1000.0+0.5, 65535.0), 0.0));
+  t->hum      = s.hum;
+  t->pot      = s.pot;
+  t->web      = s.web;
+  t->schd     = s.sch;
+  if ( !s.has(STAT_WINDOW) ) return;
+  t->duty     = uint8_t(s.duty*TELEM_DUTY + 0.5);
+  t->starts   = s.starts;
+  const int16_t mean[TELEM_SIGNALS] = {t->temp, t->tempComp, t->tmod, t->rejh};
+  for (int i=0; i<TELEM_SIGNALS; i++)
+  {
+    double per = i<3 ? 0.01 : 0.001;
+    t->lo[i]  = uint8_t(max(min(mean[i] - s.lo[i]/per + 0.5, 255.0), 0.0));
+    t->hi[i]  = uint8_t(max(min(s.hi[i]/per - mean[i] + 0.5, 255.0), 0.0));
+    t->sd[i]  = uint8_t(max(min(s.sd[i]/per + 0.5, 255.0), 0.0));
+  }
+}
+
+// Line with its "data" member, or the whole line if bare, converted
+static void convert(const char* line, const bool enc, FILE* out)
+{
+  const char* data = line;
+  int         n    = strcspn(line, "\r\n");
+  const char* key  = strstr(line, "\"data\":\"");
+  if ( key )
+  {
+    data = key + 8;
+    n    = strcspn(data, "\"");
+  }
+  char text[512];
+  int  m = -1;
+  if ( enc )
+  {
+    StatRecord s;
+    if ( s.parse(line) )
+    {
+      TelemetryRecord t;
+      encode(s, &t);
+      m = telemEncode(t, text);
+    }
+  }
+  else
+  {
+    TelemetryRecord t;
+    if ( telemDecode(data, n, &t) ) m = telemText(t, text, sizeof(text));
+  }
+  if ( m<0 )
+  {
+    fputs(line, out);
+    return;
+  }
+  converted++;
+  bytesIn  += n;
+  bytesOut += m;
+  fprintf(out, "%.*s%s%s", int(data-line), line, text, data+n);
+}
+
+int main(int argc, char** argv)
+{
+  bool  enc   = false;
+  int   first = 1;
+  if ( first<argc && strcmp(argv[first], "-e")==0 )
+  {
+    enc = true;
+    first++;
+  }
+  if ( first<argc && argv[first][0]=='-' )
+  {
+    fprintf(stderr, "usage: %s [-e] [file...]\n", argv[0]);
+    return(1);
+  }
+  char line[1024];
+  for (int i=first; i<argc || i==first; i++)
+  {
+    FILE* f = i<argc ? fopen(argv[i], "r") : stdin;
+    if ( !f )
+    {
+      fprintf(stderr, "%s: can't open %s\n", argv[0], argv[i]);
+      return(1);
+    }
+    while ( fgets(line, sizeof(line), f) ) convert(line, enc, stdout);
+    if ( f!=stdin ) fclose(f);
+  }
+  if ( converted>0 )
+    fprintf(stderr, "%s: %lu records %s, payload %5.1f bytes to %5.1f\n", argv[0], converted,
+      enc ? "encoded" : "decoded", bytesIn/converted, bytesOut/converted);
+  return(0);
+}
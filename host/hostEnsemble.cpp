@@ -0,0 +1,173 @@
+/* hostEnsemble.cpp
+  Sweep house parameters and controller gains in bulk with the batched
+  ensemble of myEnsemble.h.   Member 0 is the firmware house and gains;
+  the rest scatter the plant constants by up to 30%, the reset curve
+  breaks, Kv, HYST and the houseTrack gains.   Member 0 is also run
+  through HouseHeat, houseTrack and controlLaw themselves as a check.
+
+  Usage:  hostEnsemble [-n members] [-d days] [-j threads] [-o OAT] [-w file] [-a]
+      -n    Members (10000)
+      -d    Simulated days (7)
+      -j    Threads (all cores)
+      -o    Mean OAT, F (30), with an 8 F daily swing, coldest at 6:00
+      -w    OAT trace from the hourly means of a recorded 'stat' capture instead
+      -a    Print every member, else the 5 with least meanErr
+
+  13-Feb-2016   Dave Gutz   Created
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "application.h"
+#include "myEnsemble.h"
+#include "myReplay.h"
+
+extern double Ta_Obs;   // Modeled air temp, F, in hostStubs.cpp
+
+#define ENS_T   5.0     // Update time, FILTER_DELAY, MODEL_DELAY and READ_DELAY, s
+
+// Weekday schedule of myThermostat.ino by hour
+static const int set24[24] = {62, 62, 62, 62, 68, 68, 68, 62, 62, 62, 62, 62,
+                              62, 62, 62, 62, 68, 68, 68, 68, 68, 68, 62, 62};
+
+static double uniform(const double lo, const double hi)
+{
+  return(lo + (hi-lo)*double(random(0, 10001))/10000.0);
+}
+
+// Hourly OAT means of a capture, gaps held
+static std::vector<double> oatTrace(const char* file)
+{
+  std::vector<double> sum, n;
+  FILE* f = fopen(file, "r");
+  if ( !f ) return(sum);
+  char        line[512];
+  StatRecord  r;
+  double      t0 = -1;
+  while ( fgets(line, sizeof(line), f) )
+  {
+    if ( !r.parse(line) || !r.has(STAT_OAT) || !r.has(STAT_STAMP) ) continue;
+    if ( t0<0 ) t0 = r.stamp;
+    unsigned h = unsigned((r.stamp-t0)/3600.0);
+    if ( h>=sum.size() ) { sum.resize(h+1, 0.0); n.resize(h+1, 0.0); }
+    sum[h] += r.oat;
+    n[h]   += 1;
+  }
+  fclose(f);
+  for (unsigned h=0; h<sum.size(); h++)
+    sum[h] = n[h]>0 ? sum[h]/n[h] : (h>0 ? sum[h-1] : 30.0);
+  return(sum);
+}
+
+// Member 0 through the firmware functions, for the check
+static void reference(const double days, const std::vector<double>& oat, double* Ta, double* cycles)
+{
+  HouseHeat house("house",    HOUSE_HEAT);
+  HouseHeat emb("embHouse",   HOUSE_HEAT);
+  unsigned long steps = (unsigned long)(days*86400.0/ENS_T + 0.5);
+  bool    call = false;
+  double  callCount = 0;
+  *cycles = 0;
+  for (unsigned long k=0; k<steps; k++)
+  {
+    int     RESET = k==0;
+    double  hr    = double(k)*ENS_T/3600.0;
+    int     h     = int(hr);
+    double  o0    = oat[h % oat.size()];
+    double  OAT   = o0 + (oat[(h+1) % oat.size()]-o0)*(hr-double(h));
+    house.update(RESET, ENS_T, NOMSET, double(call), 0.0, OAT);
+    double  Ta_Sense  = house.Ta_Sense();
+    double  rejectHeat = houseTrack(RESET, double(call), Ta_Sense, Ta_Obs, ENS_T);
+    double  TaRat_Obs = emb.update(RESET, ENS_T, Ta_Sense, double(call), rejectHeat, OAT);
+    Ta_Obs            = emb.Ta();
+    bool    was       = call;
+    call              = controlLaw(call, set24[h % 24], Ta_Sense + TaRat_Obs*RATE_KV, &callCount);
+    if ( call && !was ) (*cycles)++;
+  }
+  *Ta = house.Ta();
+}
+
+int main(int argc, char** argv)
+{
+  int     members = 10000;
+  double  days    = 7.0;
+  int     threads = max(int(std::thread::hardware_concurrency()), 1);
+  double  OAT     = 30.0;
+  const char* weather = NULL;
+  bool    all     = false;
+  for (int i=1; i<argc; i++)
+  {
+    if ( strcmp(argv[i], "-n")==0 && i+1<argc ) members = atoi(argv[++i]);
+    else if ( strcmp(argv[i], "-d")==0 && i+1<argc ) days = atof(argv[++i]);
+    else if ( strcmp(argv[i], "-j")==0 && i+1<argc ) threads = atoi(argv[++i]);
+    else if ( strcmp(argv[i], "-o")==0 && i+1<argc ) OAT = atof(argv[++i]);
+    else if ( strcmp(argv[i], "-w")==0 && i+1<argc ) weather = argv[++i];
+    else if ( strcmp(argv[i], "-a")==0 ) all = true;
+    else
+    {
+      fprintf(stderr, "usage: %s [-n members] [-d days] [-j threads] [-o OAT] [-w file] [-a]\n", argv[0]);
+      return(1);
+    }
+  }
+  members = max(members, 1);
+
+  std::vector<double> oat;
+  if ( weather )
+  {
+    oat = oatTrace(weather);
+    if ( oat.empty() )
+    {
+      fprintf(stderr, "%s: no OAT in %s\n", argv[0], weather);
+      return(1);
+    }
+  }
+  else
+    for (int h=0; h<24; h++) oat.push_back(OAT - 4.0*cos((h-6)*M_PI/12.0));
+
+  HouseParams nominal;
+  Ensemble    ens(nominal, members);
+  ens.add(nominal);
+  while ( ens.size()<members )
+  {
+    HouseParams p;
+    p.Ha  *= uniform(0.7, 1.3);
+    p.Hc  *= uniform(0.7, 1.3);
+    p.Hf  *= uniform(0.7, 1.3);
+    p.Ho  *= uniform(0.7, 1.3);
+    p.Rn  += uniform(-5, 5);
+    p.Rx  += uniform(-5, 5);
+    p.Tn  += uniform(-10, 10);
+    p.Tx  += uniform(-10, 10);
+    p.Kv   = uniform(100, 800);
+    p.hyst = uniform(0.25, 1.5);
+    p.Kei  = uniform(0.5e-4, 8e-4);
+    p.Kep  = uniform(0.25, 2.0);
+    ens.add(p);
+  }
+
+  std::chrono::steady_clock::time_point wall0 = std::chrono::steady_clock::now();
+  ens.run(days, ENS_T, &oat[0], oat.size(), set24, threads);
+  double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall0).count();
+  double updates = double(members)*days*86400.0/ENS_T;
+  Serial.printf("ensemble: %d members, %4.1f days, %d threads, %d h OAT trace in %7.3f s, %6.1f M member-updates/s\n",
+    members, days, threads, int(oat.size()), wall, updates/wall/1e6);
+
+  double refTa, refCycles;
+  reference(days, oat, &refTa, &refCycles);
+  Serial.printf("check:  member 0 Ta=%8.4f cycles=%4.0f, firmware functions Ta=%8.4f cycles=%4.0f\n",
+    ens.Ta(0), ens.cycles(0), refTa, refCycles);
+
+  std::vector<int> order;
+  for (int i=0; i<members; i++) order.push_back(i);
+  if ( all )
+    for (int i=0; i<members; i++) ens.print(i);
+  else
+  {
+    std::sort(order.begin(), order.end(), [&](int a, int b){return(ens.meanErr(a)<ens.meanErr(b));});
+    ens.print(0);
+    for (int i=0; i<min(5, members); i++) ens.print(order[i]);
+  }
+  return(0);
+}
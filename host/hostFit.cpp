@@ -0,0 +1,105 @@
+/* hostFit.cpp
+  Fit the HouseHeat constants of setup() to recorded 'stat' telemetry
+  (the .txt in Data/) and print them as constructor arguments.   All files are
+  taken as the same house.   See myFit.h.   Each constant is printed with
+  its standard error and the setup() value.   When a conductance moved more
+  than a factor of e^FIT_MOVE_H or a reset curve break went to the edge of
+  the data's OAT range the constructor isn't printed, and the exit is 2,
+  unless -f.
+
+  Usage:  hostFit [-s settle_hr] [-j threads] [-i iterations] [-t] [-f] file...
+      -s    Hours after each model reset before residuals count (0.5)
+      -j    Threads for the Jacobian (all cores, at most 8 used)
+      -i    Most Levenberg-Marquardt iterations (100)
+      -t    Print each iteration
+      -f    Print the constructor even if suspect
+
+  14-Feb-2016   Dave Gutz   Created
+*/
+
+#include <chrono>
+#include <thread>
+#include "application.h"
+#include "myFit.h"
+#include "mySubs.h"
+
+static void usage(const char* name)
+{
+  fprintf(stderr, "usage: %s [-s settle_hr] [-j threads] [-i iterations] [-t] [-f] file...\n", name);
+}
+
+int main(int argc, char** argv)
+{
+  HouseFit  fit;
+  int       iterations = 100;
+  bool      trace = false;
+  bool      force = false;
+  int       first = 1;
+  fit.threads(int(std::thread::hardware_concurrency()));
+  while ( first<argc && argv[first][0]=='-' )
+  {
+    if ( strcmp(argv[first], "-s")==0 && first+1<argc ) fit.settle(atof(argv[++first]));
+    else if ( strcmp(argv[first], "-j")==0 && first+1<argc ) fit.threads(atoi(argv[++first]));
+    else if ( strcmp(argv[first], "-i")==0 && first+1<argc ) iterations = atoi(argv[++first]);
+    else if ( strcmp(argv[first], "-t")==0 ) trace = true;
+    else if ( strcmp(argv[first], "-f")==0 ) force = true;
+    else
+    {
+      usage(argv[0]);
+      return(1);
+    }
+    first++;
+  }
+  if ( first>=argc )
+  {
+    usage(argv[0]);
+    return(1);
+  }
+  for (int i=first; i<argc; i++)
+  {
+    int n = fit.load(argv[i]);
+    if ( n<0 ) fprintf(stderr, "%s: cannot open %s\n", argv[0], argv[i]);
+    else Serial.printf("%s: %d records with TEMP, CALL, OAT and time\n", argv[i], n);
+  }
+  if ( fit.size()==0 )
+  {
+    fprintf(stderr, "%s: nothing to fit\n", argv[0]);
+    return(1);
+  }
+  Serial.printf("fit: %d records, %6.1f hr, OAT %4.1f to %4.1f F\n", fit.size(), fit.hours(), fit.oatMin(), fit.oatMax());
+
+  double p[FIT_PARAMS], p0[FIT_PARAMS];
+  HouseFit::nominal(p);
+  HouseFit::nominal(p0);
+  double rms0   = fit.rms(p);
+  double worst0 = fit.worst();
+  std::chrono::steady_clock::time_point wall0 = std::chrono::steady_clock::now();
+  fit.fit(p, iterations, trace);
+  double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall0).count();
+  double rms  = fit.rms(p);
+  Serial.printf("fit: %d residuals, rms %7.4f F (setup() constants %7.4f), worst %6.3f F (%6.3f), %6.2f s\n",
+    fit.residuals(), rms, rms0, fit.worst(), worst0, wall);
+  static const char* names[FIT_PARAMS] = {"Ha", "Hc", "Hf", "Ho", "Rn", "Rx", "Tn", "Tx"};
+  unsigned bad = fit.suspect(p, p0);
+  Serial.printf("fit: J'J condition %8.3g, %d of %d resolved, standard errors from the data alone\n",
+    fit.condition(), fit.rank(), FIT_PARAMS);
+  for (int k=0; k<FIT_PARAMS; k++)
+  {
+    char  se[16];
+    if ( fit.unseen() & 1<<k ) strcpy(se, "unseen");
+    else if ( fit.stdErr(k)>=HUGE_VAL ) strcpy(se, "unresolved");
+    else if ( k<4 ) snprintf(se, sizeof(se), "x/ %8.3g", exp(min(fit.stdErr(k), 700.0)));
+    else snprintf(se, sizeof(se), "+- %8.3g", fit.stdErr(k));
+    Serial.printf("  %s %9.4g %-9s %-12s setup() %6.4g%s\n", names[k], k<4 ? p[k]*86400 : p[k],
+      k<4 ? "BTU/day/F" : "F", se, k<4 ? p0[k]*86400 : p0[k],
+      (bad & 1<<k) ? (k<4 ? "   SUSPECT, moved too far" : "   SUSPECT, at the OAT edge") : "");
+  }
+  if ( bad && !force )
+  {
+    Serial.printf("fit: not for setup(), the data doesn't hold these;  -f prints it anyway\n");
+    return(2);
+  }
+  Serial.printf("  HouseHeat(\"house\", %.4g/86400, %.4g/86400, %.4g/86400, %.4g/86400, %.4g, %.4g, %.4g, %.4g)\n",
+    p[0]*86400, p[1]*86400, p[2]*86400, p[3]*86400, p[4], p[5], p[6], p[7]);
+  return(0);
+}
@@ -0,0 +1,53 @@
+/* hostIngest.cpp
+  Stream Particle event captures (the .txt in Data/, or whole fleet archives)
+  into a columnar file per device, <dir>/<coreid>.col, for hostQuery and
+  anything else that maps them.   Existing device files are appended to.
+  See myColumns.h.
+
+  Usage:  hostIngest [-o dir] [file...]     stdin if no file, so
+              zcat fleet.txt.gz | hostIngest -o store
+      -o    Directory of the device files (.)
+
+  20-Feb-2016   Dave Gutz   Created
+*/
+
+#include <chrono>
+#include "application.h"
+#include "myColumns.h"
+
+int main(int argc, char** argv)
+{
+  const char* dir   = ".";
+  int         first = 1;
+  while ( first<argc && argv[first][0]=='-' )
+  {
+    if ( strcmp(argv[first], "-o")==0 && first+1<argc ) dir = argv[++first];
+    else
+    {
+      fprintf(stderr, "usage: %s [-o dir] [file...]\n", argv[0]);
+      return(1);
+    }
+    first++;
+  }
+  ColumnIngest ingest(dir);
+  bool ok = true;
+  auto t0 = std::chrono::steady_clock::now();
+  for (int i=first; i<argc || i==first; i++)
+  {
+    FILE* f = i<argc ? fopen(argv[i], "rb") : stdin;
+    if ( !f )
+    {
+      fprintf(stderr, "%s: can't open %s\n", argv[0], argv[i]);
+      ok = false;
+      continue;
+    }
+    ok = ingest.ingest(f) && ok;
+    if ( f!=stdin ) fclose(f);
+  }
+  ok = ingest.close() && ok;
+  double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+  fprintf(stderr, "%s: %lu lines, %lu rows to %d devices, %lu without a time, %.1f MB in %.2f s, %.0f MB/s\n",
+    argv[0], ingest.lines(), ingest.rows(), ingest.devices(), ingest.unstamped(), ingest.bytes()/1e6, s,
+    ingest.bytes()/1e6/max(s, 1e-6));
+  return(ok ? 0 : 1);
+}
@@ -0,0 +1,109 @@
+/* hostQuery.cpp
+  Rows of hostIngest device files in a time range, as CSV:
+      published_at,hh:mm,CALL,SET,TEMP,TEMPC,HUM,HELD,T,POT,WEB,SCH,OAT,TMOD,REJH
+  Fields a row didn't have are left empty.   See myColumns.h.
+
+  Usage:  hostQuery [-f from] [-t to] [-n] file.col...
+      -f    Start, yyyy-mm-ddThh:mm:ss or Unix s (the beginning)
+      -t    End, not included (the end)
+      -n    Count the rows only
+
+  20-Feb-2016   Dave Gutz   Created
+*/
+
+#include <chrono>
+#include "application.h"
+#include "myColumns.h"
+
+// Time argument, ISO or Unix s
+static bool when(const char* a, double* t)
+{
+  if ( isoStamp(a, strlen(a), t) ) return(true);
+  char* e;
+  *t = strtod(a, &e);
+  return(e!=a && *e=='\0');
+}
+
+// Row i of b
+static void row(const ColumnBlock& b, const uint32_t i)
+{
+  time_t  s  = time_t(floor(b.stamp[i]));
+  struct tm t;
+  gmtime_r(&s, &t);
+  unsigned f = b.fields[i];
+  printf("%04d-%02d-%02dT%02d:%02d:%06.3fZ,", t.tm_year+1900, t.tm_mon+1, t.tm_mday, t.tm_hour, t.tm_min,
+    t.tm_sec + b.stamp[i]-s);
+  if ( f & STAT_HM )    printf("%02d:%02d", b.minute[i]/60, b.minute[i]%60);
+  putchar(',');
+  if ( f & STAT_CALL )  printf("%d", b.call[i]);
+  putchar(',');
+  if ( f & STAT_SET )   printf("%.1f", b.set[i]);
+  putchar(',');
+  if ( f & STAT_TEMP )  printf("%.3f", b.temp[i]);
+  putchar(',');
+  if ( f & STAT_TEMPC ) printf("%.3f", b.tempc[i]);
+  putchar(',');
+  if ( f & STAT_HUM )   printf("%d", b.hum[i]);
+  putchar(',');
+  if ( f & STAT_HELD )  printf("%d", b.held[i]);
+  putchar(',');
+  if ( f & STAT_T )     printf("%.2f", b.T[i]);
+  putchar(',');
+  if ( f & STAT_POT )   printf("%d", b.pot[i]);
+  putchar(',');
+  if ( f & STAT_WEB )   printf("%d", b.web[i]);
+  putchar(',');
+  if ( f & STAT_SCH )   printf("%d", b.sch[i]);
+  putchar(',');
+  if ( f & STAT_OAT )   printf("%.1f", b.oat[i]);
+  putchar(',');
+  if ( f & STAT_TMOD )  printf("%.3f", b.tmod[i]);
+  putchar(',');
+  if ( f & STAT_REJH )  printf("%.3f", b.rejh[i]);
+  putchar('\n');
+}
+
+int main(int argc, char** argv)
+{
+  double  from  = -1e300;
+  double  to    = 1e300;
+  bool    count = false;
+  int     first = 1;
+  while ( first<argc && argv[first][0]=='-' )
+  {
+    if ( strcmp(argv[first], "-f")==0 && first+1<argc && when(argv[first+1], &from) ) first++;
+    else if ( strcmp(argv[first], "-t")==0 && first+1<argc && when(argv[first+1], &to) ) first++;
+    else if ( strcmp(argv[first], "-n")==0 ) count = true;
+    else
+    {
+      fprintf(stderr, "usage: %s [-f from] [-t to] [-n] file.col...\n", argv[0]);
+      return(1);
+    }
+    first++;
+  }
+  if ( first>=argc )
+  {
+    fprintf(stderr, "usage: %s [-f from] [-t to] [-n] file.col...\n", argv[0]);
+    return(1);
+  }
+  if ( !count ) printf("published_at,hh:mm,CALL,SET,TEMP,TEMPC,HUM,HELD,T,POT,WEB,SCH,OAT,TMOD,REJH\n");
+  int bad = 0;
+  for (int i=first; i<argc; i++)
+  {
+    ColumnFile file;
+    if ( !file.open(argv[i]) )
+    {
+      fprintf(stderr, "%s: %s is not a column file\n", argv[0], argv[i]);
+      bad++;
+      continue;
+    }
+    auto t0 = std::chrono::steady_clock::now();
+    unsigned long n = count ? file.range(from, to, [](const ColumnBlock&, const uint32_t){})
+                            : file.range(from, to, row);
+    double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    const ColumnHeader& h = file.header();
+    fprintf(stderr, "%s: %s %lu of %llu rows in %u blocks%s, %.3f ms\n", argv[0], h.coreid, n,
+      (unsigned long long)h.rows, h.blocks, h.sorted ? "" : ", out of order", s*1000.0);
+  }
+  return(bad ? 1 : 0);
+}
@@ -0,0 +1,70 @@
+/* hostReplay.cpp
+  Replay recorded 'stat' telemetry (the .txt in Data/) through the filters, the
+  embedded model and the control law and report how far the recomputed
+  TEMPC, TMOD, REJH and CALL diverge from what the thermostat published.
+  Each file is replayed from a fresh start.   See myReplay.h.
+
+  Usage:  hostReplay [-s settle_hr] [-t] file...
+      -s    Hours after start before divergence is counted (0.5)
+      -t    Trace each record as CSV:
+            hr,TEMP,TEMPC,tempComp,TMOD,Ta_Obs,REJH',CALL,call'
+
+  09-Feb-2016   Dave Gutz   Created
+*/
+
+#include <chrono>
+#include "application.h"
+#include "myReplay.h"
+
+int main(int argc, char** argv)
+{
+  double  settle = 0.5;
+  bool    trace  = false;
+  int     first  = 1;
+  while ( first<argc && argv[first][0]=='-' )
+  {
+    if ( strcmp(argv[first], "-s")==0 && first+1<argc ) settle = atof(argv[++first]);
+    else if ( strcmp(argv[first], "-t")==0 ) trace = true;
+    else
+    {
+      fprintf(stderr, "usage: %s [-s settle_hr] [-t] file...\n", argv[0]);
+      return(1);
+    }
+    first++;
+  }
+  if ( first>=argc )
+  {
+    fprintf(stderr, "usage: %s [-s settle_hr] [-t] file...\n", argv[0]);
+    return(1);
+  }
+
+  // Same as setup() in myThermostat.ino
+  HouseHeat houseEmbMod("embHouse", HOUSE_HEAT);
+  Replay    replay(houseEmbMod, RATE_KV, RATE_TAU);
+  replay.settle(settle);
+  replay.trace(trace);
+
+  for (int i=first; i<argc; i++)
+  {
+    FILE* f = fopen(argv[i], "r");
+    if ( !f )
+    {
+      fprintf(stderr, "%s: cannot open %s\n", argv[0], argv[i]);
+      continue;
+    }
+    std::chrono::steady_clock::time_point wall0 = std::chrono::steady_clock::now();
+    StatRecord    r;
+    char          line[512];
+    unsigned long skipped = 0;
+    replay.reset();
+    while ( fgets(line, sizeof(line), f) )
+    {
+      if ( !r.parse(line) || !replay.add(r) ) skipped++;
+    }
+    fclose(f);
+    double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall0).count();
+    Serial.printf("%s:  %lu lines skipped, %6.3f s\n", argv[i], skipped, wall);
+    replay.print();
+  }
+  return(0);
+}
@@ -0,0 +1,35 @@
+/* hostStubs.cpp
+  The globals of myThermostat.ino that mySubs.cpp uses, for the host tools
+  that link the thermostat core without the sketch.   hostThermostat runs
+  the sketch itself and doesn't link this.
+
+  20-Feb-2016   Dave Gutz   Created
+*/
+
+#include "application.h"
+#include "mySubs.h"
+
+int     verbose = 0;    // Debug, as much as you can tolerate
+double  Ta_Obs  = 62;   // Modeled air temp, F
+double  tempf   = 30.0; // webhook OAT, deg F
+void    displayTemperature(int temp){}
+
+// Same as myThermostat.ino
+float hourCh[7][NCH] = {
+    6, 8, 16, 22,   // Sun
+    4, 7, 16, 22,   // Mon
+    4, 7, 16, 22,   // Tue
+    4, 7, 16, 22,   // Wed
+    4, 7, 16, 22,   // Thu
+    4, 7, 16, 22,   // Fri
+    6, 8, 16, 22    // Sat
+};
+extern const float tempCh[7][NCH] = {
+    68, 62, 68, 62, // Sun
+    68, 62, 68, 62, // Mon
+    68, 62, 68, 62, // Tue
+    68, 62, 68, 62, // Wed
+    68, 62, 68, 62, // Thu
+    68, 62, 68, 62, // Fri
+    68, 62, 68, 62  // Sat
+};
@@ -0,0 +1,90 @@
+/* hostThermostat.cpp
+  Run myThermostat.ino on a Linux box against the bare-Photon house model.
+
+  The sketch itself is compiled here, with BARE_PHOTON, NO_BLYNK,
+  NO_PARTICLE and NO_WEATHER_HOOK, and its setup() and loop() are run as
+  the Particle firmware would, except that between passes the virtual
+  clock jumps straight to the next task deadline so a simulated week takes
+  a few seconds.   The cloud is connected, nothing sent, so the stat and
+  Uptime publishes report their bytes/hr against the fixed publish groups.
+
+  Usage:  hostThermostat [days [OAT [verbose [slides]]]]
+      days      Simulated time (7), days
+      OAT       Outside air temperature (30), F
+      verbose   As in the .ino (0); 2 prints the stat each publish, 3 also
+                the scheduler, flash, log and publish reports every cycle
+      slides    Web slider drags a day (0), each through 6 web demands on
+                consecutive passes, to show settings flash writes coalescing
+
+  08-Feb-2016   Dave Gutz   Created
+*/
+
+#include <chrono>
+#include "myThermostat.ino"
+
+
+int main(int argc, char** argv)
+{
+  double            days          = argc>1 ? atof(argv[1]) : 7.0;
+  OAT                             = argc>2 ? atof(argv[2]) : 30.0;
+  verbose                         = argc>3 ? atoi(argv[3]) : 0;
+  double            slides        = argc>4 ? atof(argv[4]) : 0.0;
+
+  // As a unit that was running, not a new one
+  flashShadow.begin();
+  saveTemperature(NOMSET, NOMSET, false, EEPROM_ADDR);
+  flashShadow.flush();
+  Particle.hostConnect(true);
+  setup();
+  house->integration(EXACT);                // Plant, accurate at any READ_DELAY
+
+  // Figures of merit
+  unsigned long     passes        = 0UL;
+  unsigned long     cycles        = 0UL;    // Heat calls started
+  double            onTime        = 0.0;    // Heat call time, sec
+  double            errInt        = 0.0;    // Integral of |Ta - set|, F-sec
+  double            coldInt       = 0.0;    // Integral of set - Ta when below set, F-sec
+  unsigned long     start         = millis();
+  unsigned long     end           = start + (unsigned long)(days*86400000.0);
+  unsigned long     slideEvery    = slides>0 ? (unsigned long)(86400000.0/slides) : 0UL;
+  unsigned long     nextSlide     = start + slideEvery/2;
+  int               slideStep     = 0;
+  std::chrono::steady_clock::time_point wall0 = std::chrono::steady_clock::now();
+
+  while ( millis() < end )
+  {
+    passes++;
+    if ( slideEvery>0 && (long)(millis()-nextSlide)>=0 )   // As BLYNK_WRITE(V4)
+    {
+      webDmd = 63 + slideStep%6;
+      if ( ++slideStep%6==0 ) nextSlide += slideEvery;
+    }
+    bool  was = call;
+    loop();
+    if ( call && !was ) cycles++;
+
+    // Jump to the next deadline, integrating figures of merit over the step
+    unsigned long step = max(sched.untilNext(millis()), 1UL);
+    if ( millis()+step > end ) step = end - millis();
+    double dt = double(step)/1000.0;
+    if ( call ) onTime += dt;
+    errInt  += fabs(house->Ta() - set)*dt;
+    if ( house->Ta()<set ) coldInt += (set - house->Ta())*dt;
+    hostAdvance(step);
+  }
+
+  double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall0).count();
+  double simSec = double(millis()-start)/1000.0;
+  Serial.printf("host: simulated %7.2f days in %7.3f s, %9.0fx real time, %lu passes\n",
+    simSec/86400.0, wall, simSec/max(wall, 1e-9), passes);
+  Serial.printf("house: OAT=%5.1f duty=%6.3f cycles=%lu meanErr=%6.3f F cold=%7.2f F-hr\n",
+    OAT, onTime/simSec, cycles, errInt/simSec, coldInt/3600.0);
+  Serial.printf("flash: puts=%lu bytes=%lu, settings puts=%lu commits=%lu avoided=%lu\n", EEPROM.puts(),
+    EEPROM.writes(), flashShadow.puts(), flashShadow.commits(), flashShadow.avoided());
+  Serial.printf("publish: %lu messages %6.0f bytes/hr, fixed groups %lu %6.0f bytes/hr\n",
+    pub.messages(), pub.bytesPerHour(), pub.fixedMessages(), pub.fixedPerHour());
+  Serial.printf("schedule: %lu interrogations, %lu at QUERY_DELAY\n",
+    sched.task(schdTask).runs, (unsigned long)(simSec*1000.0/QUERY_DELAY));
+  Serial.printf("dim: posted=%lu run=%lu\n", dimPosted, dimRuns);
+  return(0);
+}
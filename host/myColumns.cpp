@@ -0,0 +1,269 @@
+// Columnar store of recorded telemetry, see myColumns.h
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "myColumns.h"
+
+// Row i of b from r
+static void setRow(ColumnBlock* b, const uint32_t i, const StatRecord& r)
+{
+  b->stamp[i]   = r.stamp;
+  b->set[i]     = r.set;
+  b->temp[i]    = r.temp;
+  b->tempc[i]   = r.tempc;
+  b->tmod[i]    = r.tmod;
+  b->oat[i]     = r.oat;
+  b->rejh[i]    = r.rejh;
+  b->T[i]       = r.T;
+  b->fields[i]  = r.fields;
+  b->minute[i]  = r.minute;
+  b->call[i]    = r.call;
+  b->held[i]    = r.held;
+  b->hum[i]     = r.hum;
+  b->pot[i]     = r.pot;
+  b->web[i]     = r.web;
+  b->sch[i]     = r.sch;
+}
+
+
+// ColumnWriter Class Functions
+// Constructors
+// Appends to an existing file of the device, else starts one
+ColumnWriter::ColumnWriter(const char* dir, const char* coreid)
+  : block_(new ColumnBlock), ok_(true)
+{
+  snprintf(path_, sizeof(path_), "%s/%s.col", dir, coreid);
+  memset(&head_, 0, sizeof(head_));
+  memset(block_, 0, sizeof(ColumnBlock));
+  FILE* f = fopen(path_, "rb");
+  if ( f )
+  {
+    ok_ = fread(&head_, sizeof(head_), 1, f)==1 && strcmp(head_.magic, COL_MAGIC)==0 &&
+          head_.version==COL_VERSION && head_.rowsPerBlock==COL_ROWS;
+    if ( ok_ && head_.blocks>0 )
+    {
+      ok_ = fseek(f, sizeof(head_) + (head_.blocks-1)*sizeof(ColumnBlock), SEEK_SET)==0 &&
+            fread(block_, sizeof(ColumnBlock), 1, f)==1;
+      if ( ok_ && block_->n==COL_ROWS ) memset(block_, 0, sizeof(ColumnBlock));
+      else head_.blocks--;      // Part full, rewritten in place
+    }
+    fclose(f);
+    if ( !ok_ ) fprintf(stderr, "%s:  not a version %d column file, left alone\n", path_, COL_VERSION);
+    return;
+  }
+  strcpy(head_.magic, COL_MAGIC);
+  head_.version       = COL_VERSION;
+  head_.rowsPerBlock  = COL_ROWS;
+  head_.sorted        = 1;
+  strncpy(head_.coreid, coreid, sizeof(head_.coreid)-1);
+  f = fopen(path_, "wb");
+  ok_ = f && fwrite(&head_, sizeof(head_), 1, f)==1;
+  if ( f ) fclose(f);
+  if ( !ok_ ) fprintf(stderr, "%s:  can't write\n", path_);
+}
+ColumnWriter::~ColumnWriter(void)
+{
+  delete block_;
+}
+// Functions
+bool ColumnWriter::add(const StatRecord& r)
+{
+  if ( !ok_ ) return(false);
+  ColumnBlock* b = block_;
+  if ( b->n==0 )
+  {
+    b->t0     = r.stamp;
+    b->t1     = r.stamp;
+    b->sorted = 1;
+  }
+  if ( r.stamp<b->t1 ) b->sorted = 0;
+  double last = head_.rows>0 ? head_.t1 : r.stamp;
+  if ( r.stamp<last ) head_.sorted = 0;
+  b->t0 = min(b->t0, r.stamp);
+  b->t1 = max(b->t1, r.stamp);
+  head_.t0 = head_.rows>0 ? min(head_.t0, r.stamp) : r.stamp;
+  head_.t1 = max(last, r.stamp);
+  setRow(b, b->n++, r);
+  head_.rows++;
+  if ( b->n==COL_ROWS )
+  {
+    if ( !writeBlock_() ) return(false);
+    head_.blocks++;
+    memset(b, 0, sizeof(ColumnBlock));
+  }
+  return(true);
+}
+// Write the last block and the header
+bool ColumnWriter::close(void)
+{
+  if ( !ok_ ) return(false);
+  if ( block_->n>0 && !writeBlock_() ) return(false);   // Kept, rewritten if added to
+  return(writeHeader_());
+}
+bool ColumnWriter::writeBlock_(void)
+{
+  FILE* f = fopen(path_, "r+b");
+  ok_ = f && fseek(f, sizeof(head_) + head_.blocks*sizeof(ColumnBlock), SEEK_SET)==0 &&
+        fwrite(block_, sizeof(ColumnBlock), 1, f)==1;
+  if ( f ) ok_ = fclose(f)==0 && ok_;
+  if ( !ok_ ) fprintf(stderr, "%s:  write failed\n", path_);
+  return(ok_);
+}
+bool ColumnWriter::writeHeader_(void)
+{
+  ColumnHeader h = head_;
+  if ( block_->n>0 ) h.blocks++;
+  FILE* f = fopen(path_, "r+b");
+  ok_ = f && fwrite(&h, sizeof(h), 1, f)==1;
+  if ( f ) ok_ = fclose(f)==0 && ok_;
+  if ( !ok_ ) fprintf(stderr, "%s:  write failed\n", path_);
+  return(ok_);
+}
+
+
+// ColumnIngest Class Functions
+// Constructors
+ColumnIngest::ColumnIngest(const char* dir)
+  : buf_(new char[COL_READ+COL_LINE+1]), last_(NULL), devices_(0), ok_(true), lines_(0UL),
+  rows_(0UL), unstamped_(0UL), bytes_(0)
+{
+  strncpy(dir_, dir, sizeof(dir_)-1);
+  dir_[sizeof(dir_)-1] = '\0';
+  memset(table_, 0, sizeof(table_));
+}
+ColumnIngest::~ColumnIngest(void)
+{
+  close();
+  delete[] buf_;
+}
+// Functions
+// Stream one capture.   False if a device file couldn't be written.
+bool ColumnIngest::ingest(FILE* f)
+{
+  size_t  have = 0;       // Bytes of a line carried over to the front of buf_
+  size_t  got;
+  bool    skip = false;   // Carrying over a line longer than COL_LINE
+  while ( (got = fread(buf_+have, 1, COL_READ, f))>0 )
+  {
+    bytes_ += got;
+    char* p   = buf_;
+    char* end = buf_ + have + got;
+    char* nl;
+    while ( (nl = (char*)memchr(p, '\n', end-p)) )
+    {
+      *nl = '\0';
+      if ( !skip ) line_(p);
+      skip = false;
+      p = nl+1;
+    }
+    have = end-p;
+    if ( have>COL_LINE )
+    {
+      skip = true;
+      have = 0;
+    }
+    else memmove(buf_, p, have);
+  }
+  if ( have>0 && !skip )
+  {
+    buf_[have] = '\0';
+    line_(buf_);
+  }
+  return(ok_);
+}
+void ColumnIngest::line_(const char* line)
+{
+  lines_++;
+  if ( !rec_.parse(line) ) return;
+  if ( !rec_.has(STAT_STAMP) )
+  {
+    unstamped_++;
+    return;
+  }
+  ColumnWriter* w = last_;
+  if ( !w || strcmp(w->coreid(), rec_.coreid)!=0 )
+  {
+    bool named = rec_.coreid[0]!='\0';       // Device ids are hex, anything else would name a path
+    for (const char* c=rec_.coreid; *c && named; c++) named = isalnum(*c);
+    w = last_ = writer_(named ? rec_.coreid : "unknown");
+  }
+  if ( !w ) return;
+  if ( w->add(rec_) ) rows_++;
+  else ok_ = false;
+}
+// Writer of a device, made the first time it is seen
+ColumnWriter* ColumnIngest::writer_(const char* coreid)
+{
+  uint32_t h = 2166136261u;           // FNV-1a
+  for (const char* c=coreid; *c; c++) h = (h ^ uint8_t(*c))*16777619u;
+  for (int probe=0; probe<COL_HASH; probe++)
+  {
+    ColumnWriter*& w = table_[(h+probe) & (COL_HASH-1)];
+    if ( w && strcmp(w->coreid(), coreid)==0 ) return(w);
+    if ( w ) continue;
+    w = new ColumnWriter(dir_, coreid);
+    devices_++;
+    return(w);
+  }
+  fprintf(stderr, "more than %d devices, %s passed over\n", COL_HASH, coreid);
+  return(NULL);
+}
+// Finish every device file
+bool ColumnIngest::close(void)
+{
+  for (int i=0; i<COL_HASH; i++)
+  {
+    if ( !table_[i] ) continue;
+    if ( !table_[i]->close() ) ok_ = false;
+    delete table_[i];
+    table_[i] = NULL;
+  }
+  last_ = NULL;
+  return(ok_);
+}
+
+
+// ColumnFile Class Functions
+// Constructors
+ColumnFile::ColumnFile(void)
+  : map_(NULL), size_(0), head_(NULL), blocks_(NULL)
+{}
+ColumnFile::~ColumnFile(void)
+{
+  close();
+}
+// Functions
+bool ColumnFile::open(const char* path)
+{
+  close();
+  int fd = ::open(path, O_RDONLY);
+  if ( fd<0 ) return(false);
+  struct stat st;
+  if ( fstat(fd, &st)==0 && size_t(st.st_size)>=sizeof(ColumnHeader) )
+  {
+    size_ = st.st_size;
+    map_  = mmap(NULL, size_, PROT_READ, MAP_SHARED, fd, 0);
+    if ( map_==MAP_FAILED ) map_ = NULL;
+  }
+  ::close(fd);
+  if ( !map_ ) return(false);
+  head_ = (const ColumnHeader*)map_;
+  if ( strcmp(head_->magic, COL_MAGIC)!=0 || head_->version!=COL_VERSION || head_->rowsPerBlock!=COL_ROWS ||
+       sizeof(ColumnHeader) + head_->blocks*sizeof(ColumnBlock)>size_ )
+  {
+    close();
+    return(false);
+  }
+  blocks_ = (const ColumnBlock*)(head_+1);
+  madvise(map_, size_, MADV_SEQUENTIAL);
+  return(true);
+}
+void ColumnFile::close(void)
+{
+  if ( map_ ) munmap(map_, size_);
+  map_    = NULL;
+  size_   = 0;
+  head_   = NULL;
+  blocks_ = NULL;
+}
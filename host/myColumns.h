@@ -0,0 +1,191 @@
+/***************************************************
+  Columnar store of recorded 'stat' telemetry, one file per device
+
+  ColumnIngest streams Particle event captures (see myReplay.h for the
+  formats) in one pass:  input is read in COL_READ chunks and split into
+  lines in place, each line is parsed into the one StatRecord, and the
+  row goes to the ColumnWriter of its coreid.   Nothing is allocated
+  per line;  each device gets one ColumnBlock the first time it is seen.
+  Rows need a time, published_at or a statlog TIME;  bare captures have
+  none and are counted and passed over.
+
+  A device file, <dir>/<coreid>.col, is a ColumnHeader followed by
+  ColumnBlocks of COL_ROWS rows.   Within a block every field is its own
+  array, so a scan of one channel touches only that channel, and the
+  layout is the in-memory one, so ColumnFile maps the file and reads the
+  blocks in place.   Each block keeps its time range:  a range query
+  passes over blocks outside it without touching them and, when the
+  stamps are in order, bisects for the start of the range.   Out of order input
+  (merged archives, late statlog) is stored as it comes and the header
+  says so;  queries then test every row of the blocks they can't skip.
+
+  Writing an existing file appends to it, so daily captures can be added
+  as they come.   Block and header writes open the file and close it
+  again, so a fleet isn't limited by open files.   Files are host byte
+  order.
+
+  Class code for host application.
+
+  20-Feb-2016   Dave Gutz   Created
+ ****************************************************/
+
+#ifndef _myColumns_H
+#define _myColumns_H
+
+#include "application.h"
+#include "myReplay.h"
+
+#define COL_MAGIC   "THRMCOL"       // ColumnHeader magic, with its terminator
+#define COL_VERSION 1               // ColumnHeader and ColumnBlock layout
+#define COL_ROWS    1024            // Rows per block
+#define COL_READ    (1<<20)         // Input read size, bytes
+#define COL_LINE    4096            // Longest line kept, bytes
+#define COL_HASH    4096            // Device table slots, a power of 2
+
+
+// Start of a device file
+struct ColumnHeader
+{
+  char      magic[8];       // COL_MAGIC
+  uint32_t  version;        // COL_VERSION
+  uint32_t  rowsPerBlock;   // COL_ROWS
+  uint64_t  rows;           // Rows in the file
+  uint32_t  blocks;         // Blocks in the file, the last maybe part full
+  uint32_t  sorted;         // Stamps never decrease
+  double    t0;             // Earliest stamp, Unix s
+  double    t1;             // Latest stamp, Unix s
+  char      coreid[32];     // Device id
+  uint8_t   spare[40];
+};
+
+// COL_ROWS rows, one array per field.   Absent fields are zero and clear in fields.
+struct ColumnBlock
+{
+  double    t0;             // Earliest stamp in the block, Unix s
+  double    t1;             // Latest
+  uint32_t  n;              // Rows used
+  uint32_t  sorted;         // Stamps in this block never decrease
+  double    stamp[COL_ROWS];    // published_at or TIME, Unix s
+  float     set[COL_ROWS];      // SET as published
+  float     temp[COL_ROWS];     // TEMP, F
+  float     tempc[COL_ROWS];    // TEMPC, F
+  float     tmod[COL_ROWS];     // TMOD, F
+  float     oat[COL_ROWS];      // OAT, F
+  float     rejh[COL_ROWS];     // REJH
+  float     T[COL_ROWS];        // T, s
+  uint16_t  fields[COL_ROWS];   // STAT_ flags of fields present
+  uint16_t  minute[COL_ROWS];   // hh:mm as minute of day
+  uint8_t   call[COL_ROWS];     // CALL
+  uint8_t   held[COL_ROWS];     // HELD
+  uint8_t   hum[COL_ROWS];      // HUM, %
+  int8_t    pot[COL_ROWS];      // POT, F
+  int8_t    web[COL_ROWS];      // WEB, F
+  int8_t    sch[COL_ROWS];      // SCH, F
+};
+
+
+// Appends rows to one device file
+class ColumnWriter
+{
+public:
+  ColumnWriter(const char* dir, const char* coreid);
+  ~ColumnWriter(void);
+  bool    add(const StatRecord& r);
+  bool    close(void);
+  const char* coreid(void){return(head_.coreid);};
+  bool    ok(void){return(ok_);};
+private:
+  bool    writeBlock_(void);
+  bool    writeHeader_(void);
+  char    path_[512];     // File
+  ColumnHeader  head_;    // As it will be written
+  ColumnBlock*  block_;   // Last block, being filled
+  bool    ok_;            // No write has failed
+};
+
+
+// Streams captures into a directory of device files
+class ColumnIngest
+{
+public:
+  ColumnIngest(const char* dir);
+  ~ColumnIngest(void);
+  bool    ingest(FILE* f);
+  bool    close(void);
+  unsigned long lines(void){return(lines_);};
+  unsigned long rows(void){return(rows_);};
+  unsigned long unstamped(void){return(unstamped_);};
+  double  bytes(void){return(bytes_);};
+  int     devices(void){return(devices_);};
+private:
+  void    line_(const char* line);
+  ColumnWriter* writer_(const char* coreid);
+  char    dir_[400];      // Output directory
+  char*   buf_;           // Read buffer, COL_READ plus a line carried over
+  ColumnWriter* table_[COL_HASH]; // Writers by coreid hash, open addressed
+  ColumnWriter* last_;    // Writer of the last row
+  StatRecord    rec_;     // Parsed line
+  int     devices_;
+  bool    ok_;
+  unsigned long lines_;
+  unsigned long rows_;
+  unsigned long unstamped_;   // Records with no time
+  double  bytes_;
+};
+
+
+// A device file mapped for reading
+class ColumnFile
+{
+public:
+  ColumnFile(void);
+  ~ColumnFile(void);
+  bool    open(const char* path);
+  void    close(void);
+  const ColumnHeader& header(void) const {return(*head_);};
+  const ColumnBlock&  block(const uint32_t k) const {return(blocks_[k]);};
+  uint32_t  blocks(void) const {return(head_ ? head_->blocks : 0);};
+  template <class F> unsigned long range(const double t0, const double t1, F f) const;
+private:
+  void*   map_;           // Mapping
+  size_t  size_;          // Its length
+  const ColumnHeader* head_;
+  const ColumnBlock*  blocks_;
+};
+
+// Call f(block, row) for every row with t0 <= stamp < t1, in file order.
+// Returns the rows found.
+template <class F> unsigned long ColumnFile::range(const double t0, const double t1, F f) const
+{
+  unsigned long found = 0;
+  for (uint32_t k=0; k<blocks(); k++)
+  {
+    const ColumnBlock& b = blocks_[k];
+    if ( b.n==0 || b.t1<t0 || b.t0>=t1 ) continue;
+    uint32_t i = 0;
+    if ( b.sorted )
+    {
+      uint32_t hi = b.n;
+      while ( i<hi )
+      {
+        uint32_t mid = (i+hi)/2;
+        if ( b.stamp[mid]<t0 ) i = mid+1;
+        else hi = mid;
+      }
+      for ( ; i<b.n && b.stamp[i]<t1; i++, found++) f(b, i);
+    }
+    else
+    {
+      for ( ; i<b.n; i++)
+        if ( b.stamp[i]>=t0 && b.stamp[i]<t1 )
+        {
+          f(b, i);
+          found++;
+        }
+    }
+  }
+  return(found);
+}
+
+
+#endif
@@ -0,0 +1,197 @@
+// Batched closed-loop house simulation, see myEnsemble.h
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "myEnsemble.h"
+#include "mySubs.h"
+
+#define ENS_FIELDS  27              // Arrays per member
+
+// HouseParams, firmware values
+HouseParams::HouseParams(void)
+  : Ha(HOUSE_HA), Hc(HOUSE_HC), Hf(HOUSE_HF), Ho(HOUSE_HO), Rn(HOUSE_RN), Rx(HOUSE_RX), Tn(HOUSE_TN), Tx(HOUSE_TX),
+  Kv(RATE_KV), hyst(HYST), Kei(2e-4), Kep(1)
+{}
+
+
+// Ensemble Class Functions
+// Constructors
+Ensemble::Ensemble(const HouseParams& embMod, const int capacity)
+  : emb_(embMod), capacity_(capacity), n_(0), T_(0), steps_(0), secs_(0), oat_(NULL), hours_(0), set24_(NULL)
+{
+  double* p = new double[ENS_FIELDS*capacity];
+  memset(p, 0, ENS_FIELDS*capacity*sizeof(double));
+  double** f[ENS_FIELDS] = {&Ha_, &Hc_, &Hf_, &Ho_, &Rn_, &Rx_, &Tn_, &Tx_, &Kv_, &hyst_, &Kei_, &Kep_,
+    &Tw_, &Ta_, &Tc_, &eTw_, &eTa_, &eTc_, &intE_, &TaObs_, &callCount_, &call_,
+    &on_, &cycles_, &err_, &cold_, &peak_};
+  for (int i=0; i<ENS_FIELDS; i++) *f[i] = p + i*capacity;
+}
+Ensemble::~Ensemble(void)
+{
+  delete[] Ha_;
+}
+// Add a member, returns its index or -1 when full
+int Ensemble::add(const HouseParams& p)
+{
+  if ( n_>=capacity_ ) return(-1);
+  Ha_[n_] = p.Ha;   Hc_[n_] = p.Hc;   Hf_[n_] = p.Hf;   Ho_[n_] = p.Ho;
+  Rn_[n_] = p.Rn;   Rx_[n_] = p.Rx;   Tn_[n_] = p.Tn;   Tx_[n_] = p.Tx;
+  Kv_[n_] = p.Kv;   hyst_[n_] = p.hyst; Kei_[n_] = p.Kei; Kep_[n_] = p.Kep;
+  return(n_++);
+}
+// Simulate every member for days from midnight at update time T, s.   oat is
+// hourly, interpolated and repeated;  set24 is the setpoint by hour of day.
+void Ensemble::run(const double days, const double T, const double* oat, const int hours,
+  const int* set24, const int threads)
+{
+  T_      = T;
+  steps_  = (unsigned long)(days*86400.0/T + 0.5);
+  secs_   = double(steps_)*T;
+  oat_    = oat;
+  hours_  = hours;
+  set24_  = set24;
+  int blocks = (n_ + ENS_BLOCK - 1)/ENS_BLOCK;
+  std::atomic<int> next(0);
+  auto work = [&](){
+    int b;
+    while ( (b = next++) < blocks ) block_(b*ENS_BLOCK, min((b+1)*ENS_BLOCK, n_));
+  };
+  std::vector<std::thread> pool;
+  for (int i=1; i<threads; i++) pool.push_back(std::thread(work));
+  work();
+  for (unsigned i=0; i<pool.size(); i++) pool[i].join();
+}
+// Step members [b0, b1) through the whole run.   Arrays are taken as local
+// restrict pointers, and ivdep because gcc stops trusting restrict past a
+// handful of streams, so the member loops vectorize.
+void Ensemble::block_(const int b0, const int b1)
+{
+  const double T    = T_;
+  const double eHa  = emb_.Ha;
+  const double eHc  = emb_.Hc;
+  const double eHf  = emb_.Hf;
+  const double eHo  = emb_.Ho;
+  const int    n    = b1 - b0;
+  const double* __restrict Ha   = Ha_ + b0;
+  const double* __restrict Hc   = Hc_ + b0;
+  const double* __restrict Hf   = Hf_ + b0;
+  const double* __restrict Ho   = Ho_ + b0;
+  const double* __restrict Rn   = Rn_ + b0;
+  const double* __restrict Rx   = Rx_ + b0;
+  const double* __restrict Tn   = Tn_ + b0;
+  const double* __restrict Tx   = Tx_ + b0;
+  const double* __restrict Kv   = Kv_ + b0;
+  const double* __restrict hyst = hyst_ + b0;
+  const double* __restrict Kei  = Kei_ + b0;
+  const double* __restrict Kep  = Kep_ + b0;
+  double* __restrict Tw     = Tw_ + b0;
+  double* __restrict Ta     = Ta_ + b0;
+  double* __restrict Tc     = Tc_ + b0;
+  double* __restrict eTw    = eTw_ + b0;
+  double* __restrict eTa    = eTa_ + b0;
+  double* __restrict eTc    = eTc_ + b0;
+  double* __restrict intE   = intE_ + b0;
+  double* __restrict TaObs  = TaObs_ + b0;
+  double* __restrict callCount = callCount_ + b0;
+  double* __restrict calls  = call_ + b0;
+  double* __restrict on     = on_ + b0;
+  double* __restrict cycles = cycles_ + b0;
+  double* __restrict err    = err_ + b0;
+  double* __restrict cold   = cold_ + b0;
+  double* __restrict peak   = peak_ + b0;
+
+  // Plant as HouseHeat RESET to NOMSET
+  double OAT = oat_[0];
+#pragma GCC ivdep
+  for (int i=0; i<n; i++)
+  {
+    Ta[i]     = NOMSET;
+    Tw[i]     = (OAT*Ho[i]+Ta[i]*Ha[i])/(Ho[i]+Ha[i]);
+    Tc[i]     = (Ta[i]*(Ha[i]+Hc[i])-Tw[i]*Ha[i])/Hc[i];
+    TaObs[i]  = ENS_TA_OBS;
+    intE[i]   = 0;
+    callCount[i] = 0;
+    calls[i]  = 0;
+    on[i]     = 0;
+    cycles[i] = 0;
+    err[i]    = 0;
+    cold[i]   = 0;
+    peak[i]   = -1e6;
+  }
+
+  for (unsigned long k=0; k<steps_; k++)
+  {
+    double hr   = double(k)*T/3600.0;
+    int    h    = int(hr);
+    double o0   = oat_[h % hours_];
+    double o1   = oat_[(h+1) % hours_];
+    OAT         = o0 + (o1-o0)*(hr-double(h));
+    double set  = set24_[h % 24];
+    double eTb  = max(min((OAT-emb_.Rn)/(emb_.Rx-emb_.Rn)*(emb_.Tx-emb_.Tn)+emb_.Tn, emb_.Tn), emb_.Tx);
+
+    // Plant, read task
+#pragma GCC ivdep
+    for (int i=0; i<n; i++)
+    {
+      double Tb     = max(min((OAT-Rn[i])/(Rx[i]-Rn[i])*(Tx[i]-Tn[i])+Tn[i], Tn[i]), Tx[i]);
+      double dTw_dt = -(Tw[i]-Ta[i])*Ha[i] - (Tw[i]-OAT)*Ho[i];
+      double dTa_dt = -(Ta[i]-Tw[i])*Ha[i] - (Ta[i]-Tc[i])*Hc[i];
+      double dTc_dt = -(Tc[i]-Ta[i])*Hc[i] + calls[i]*(Tb-Tc[i])*Hf[i];
+      Tw[i]   = min(max(Tw[i]+dTw_dt*T, -40.0), 120.0);
+      Ta[i]   = min(max(Ta[i]+dTa_dt*T, -40.0), 120.0);
+      Tc[i]   = min(max(Tc[i]+dTc_dt*T, -40.0), 120.0);
+    }
+
+    // Embedded model RESET to the first sensed temp
+    if ( k==0 )
+      for (int i=0; i<n; i++)
+    {
+      eTa[i]  = Ta[i];
+      eTw[i]  = (OAT*eHo+eTa[i]*eHa)/(eHo+eHa);
+      eTc[i]  = (eTa[i]*(eHa+eHc)-eTw[i]*eHa)/eHc;
+    }
+
+    // Model and control tasks
+#pragma GCC ivdep
+    for (int i=0; i<n; i++)
+    {
+      double TaS    = Ta[i];
+      double ePI    = TaS - TaObs[i];
+      double iE     = max(min(intE[i] + Kei[i]*ePI*T, 1.0), -1.0);
+      double rej    = (iE + max(min(Kep[i]*ePI, 1.0), -1.0))*0.005;
+      double dTw_dt = -(eTw[i]-eTa[i])*eHa - (eTw[i]-OAT)*eHo;
+      double dTa_dt = -(eTa[i]-eTw[i])*eHa - (eTa[i]-eTc[i])*eHc;
+      double dTc_dt = -(eTc[i]-eTa[i])*eHc + calls[i]*(eTb-eTc[i])*eHf + rej;
+      double eA     = min(max(eTa[i]+dTa_dt*T, -40.0), 120.0);
+      eTw[i]        = min(max(eTw[i]+dTw_dt*T, -40.0), 120.0);
+      eTc[i]        = min(max(eTc[i]+dTc_dt*T, -40.0), 120.0);
+      eTa[i]        = eA;
+      TaObs[i]      = eA;
+      intE[i]       = iE;
+      double tempComp = TaS + dTa_dt*Kv[i];
+      double was    = calls[i];
+      double band   = (2.0*was - 1.0)*hyst[i];       // +hyst calling, -hyst not
+      double callRaw  = (set + band) > tempComp ? 1.0 : 0.0;
+      double cc     = callCount[i] + max(min(callRaw-callCount[i], 0.2), -0.2);
+      cc            = max(min(cc, 1.0), 0.0);
+      double call   = cc>=1.0 ? 1.0 : 0.0;
+      double e      = TaS - set;
+      cycles[i]    += call*(1.0-was);
+      callCount[i]  = cc;
+      calls[i]      = call;
+      on[i]        += call*T;
+      err[i]       += (e<0 ? -e : e)*T;
+      cold[i]      += max(-e, 0.0)*T;
+      peak[i]       = max(peak[i], e);
+    }
+  }
+}
+// One line of parameters and metrics
+void Ensemble::print(const int i)
+{
+  Serial.printf("%5d Ha=%5.2f Hc=%6.1f Hf=%5.2f Ho=%6.1f Rn=%4.1f Rx=%4.1f Tn=%5.1f Tx=%5.1f Kv=%5.0f hyst=%4.2f Kei=%7.1e Kep=%4.2f"
+    " | duty=%5.3f cycles/day=%5.1f meanErr=%5.3f cold=%6.2f peak=%5.2f\n",
+    i, Ha_[i]*86400, Hc_[i]*86400, Hf_[i]*86400, Ho_[i]*86400, Rn_[i], Rx_[i], Tn_[i], Tx_[i],
+    Kv_[i], hyst_[i], Kei_[i], Kep_[i],
+    duty(i), cycles_[i]/(secs_/86400.0), meanErr(i), cold(i), peak_[i]);
+}
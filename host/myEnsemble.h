@@ -0,0 +1,93 @@
+/***************************************************
+  Batched closed-loop simulation of many houses at once
+
+  Each member is a bare-Photon house (HouseHeat plant parameters) under
+  the thermostat core:  the firmware embedded model, houseTrack rejection
+  and the control law, with its own Kv, HYST and houseTrack gains.   The
+  embedded model parameters are the firmware's and the same for every
+  member, so a member whose plant differs from it is tracked the way a
+  real install would be.
+
+  State is kept as structure-of-arrays and members are stepped in blocks
+  of ENS_BLOCK with branch-free loops the compiler can vectorize.   run()
+  hands blocks to a pool of threads;  a block stays in cache for the
+  whole simulated time.   All members share one hourly OAT trace and one
+  hourly setpoint schedule.
+
+  The step is a single T (5 s) for read, model and control, where loop()
+  runs control at 4 s, and the plant has no sensor noise.   Otherwise the
+  arithmetic is that of HouseHeat::update (EULER), houseTrack and
+  controlLaw, so member results can be checked against them.
+
+  Class code for host application.
+
+  13-Feb-2016   Dave Gutz   Created
+ ****************************************************/
+
+#ifndef _myEnsemble_H
+#define _myEnsemble_H
+
+#include "application.h"
+
+#define ENS_BLOCK   64              // Members stepped together by one thread
+#define ENS_TA_OBS  62.0            // Ta_Obs before the first model pass, F, as the .ino
+
+
+// House and controller parameters of one member
+struct HouseParams
+{
+  HouseParams(void);
+  double  Ha;         // Air to wall constant, BTU/sec/F
+  double  Hc;         // Core to air constant, BTU/sec/F
+  double  Hf;         // Firing constant, BTU/sec/F
+  double  Ho;         // Wall to outside constant, BTU/sec/F
+  double  Rn;         // Low boiler reset curve OAT break, F
+  double  Rx;         // High boiler reset curve OAT break, F
+  double  Tn;         // Low boiler reset curve setpoint break, F
+  double  Tx;         // High boiler reset curve setpoint break, F
+  double  Kv;         // Rate gain, F/(F/sec)
+  double  hyst;       // Control law hysteresis, F
+  double  Kei;        // Rejection PI integrator gain, (r/s)/F
+  double  Kep;        // Rejection PI proportional gain, F/F
+};
+
+
+class Ensemble
+{
+public:
+  Ensemble(const HouseParams& embMod, const int capacity);
+  ~Ensemble(void);
+  int     add(const HouseParams& p);
+  int     size(void){return(n_);};
+  void    run(const double days, const double T, const double* oat, const int hours,
+            const int* set24, const int threads);
+  // Metrics of the last run, per member
+  double  duty(const int i){return(on_[i]/secs_);};
+  double  cycles(const int i){return(cycles_[i]);};
+  double  meanErr(const int i){return(err_[i]/secs_);};        // Mean |Ta - set|, F
+  double  cold(const int i){return(cold_[i]/3600.0);};         // Ta below set, F-hr
+  double  peak(const int i){return(peak_[i]);};                // Most Ta above set, F
+  double  Ta(const int i){return(Ta_[i]);};                    // Final air temp, F
+  void    print(const int i);
+private:
+  void    block_(const int b0, const int b1);
+  HouseParams emb_;       // Embedded model, firmware values
+  int     capacity_;
+  int     n_;             // Members
+  // Parameters
+  double  *Ha_, *Hc_, *Hf_, *Ho_, *Rn_, *Rx_, *Tn_, *Tx_, *Kv_, *hyst_, *Kei_, *Kep_;
+  // Plant, embedded model, rejection and control states
+  double  *Tw_, *Ta_, *Tc_, *eTw_, *eTa_, *eTc_, *intE_, *TaObs_, *callCount_, *call_;
+  // Metrics
+  double  *on_, *cycles_, *err_, *cold_, *peak_;
+  // Run inputs
+  double        T_;       // Update time, s
+  unsigned long steps_;   // Updates per member
+  double        secs_;    // Simulated time, s
+  const double* oat_;     // Hourly OAT, F, repeats
+  int           hours_;   // Length of oat_
+  const int*    set24_;   // Setpoint by hour of day, F
+};
+
+
+#endif
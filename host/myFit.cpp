@@ -0,0 +1,335 @@
+// HouseHeat identification, see myFit.h
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "myFit.h"
+#include "myReplay.h"
+#include "mySubs.h"
+
+// HouseFit Class Functions
+// Constructors
+HouseFit::HouseFit(void)
+  : s_(new FitSample[FIT_MAX]), n_(0), m_(0), settle_(0.5), threads_(1), worst_(0),
+  oatMin_(1e6), oatMax_(-1e6), hours_(0), cond_(0), rank_(0), unseen_(0)
+{
+  for (int k=0; k<FIT_PARAMS; k++) se_[k] = 0;
+}
+HouseFit::~HouseFit(void)
+{
+  delete[] s_;
+}
+// The constants in setup()
+void HouseFit::nominal(double* p)
+{
+  const double n[FIT_PARAMS] = {HOUSE_HEAT};
+  for (int k=0; k<FIT_PARAMS; k++) p[k] = n[k];
+}
+// Append the usable records of a capture, returns how many
+int HouseFit::load(const char* file)
+{
+  FILE* f = fopen(file, "r");
+  if ( !f ) return(-1);
+  char        line[512];
+  StatRecord  r;
+  int         count = 0;
+  const unsigned need = STAT_STAMP | STAT_TEMP | STAT_CALL | STAT_OAT;
+  while ( n_<FIT_MAX && fgets(line, sizeof(line), f) )
+  {
+    if ( !r.parse(line) || !r.has(need) ) continue;
+    FitSample& s = s_[n_];
+    s.t     = r.stamp;
+    s.temp  = r.temp;
+    s.oat   = r.oat;
+    s.call  = r.call;
+    s.reset = count==0 || s.t<=s_[n_-1].t || s.t-s_[n_-1].t>FIT_GAP;
+    if ( !s.reset ) hours_ += (s.t-s_[n_-1].t)/3600.0;
+    oatMin_ = min(oatMin_, s.oat);
+    oatMax_ = max(oatMax_, s.oat);
+    n_++;
+    count++;
+  }
+  fclose(f);
+  return(count);
+}
+// Parameters as fitted:  log conductances, BTU/day/F, and the reset curve breaks
+void HouseFit::toTheta_(const double* p, double* theta)
+{
+  for (int k=0; k<4; k++) theta[k] = log(p[k]*86400.0);
+  for (int k=4; k<FIT_PARAMS; k++) theta[k] = p[k];
+}
+void HouseFit::fromTheta_(const double* theta, double* p)
+{
+  for (int k=0; k<4; k++) p[k] = exp(theta[k])/86400.0;
+  for (int k=4; k<FIT_PARAMS; k++) p[k] = theta[k];
+}
+void HouseFit::bound_(double* theta)
+{
+  for (int k=0; k<4; k++) theta[k] = max(min(theta[k], log(1e4)), log(1e-3));
+  theta[4] = max(min(theta[4], 70.0), -30.0);   // Rn
+  theta[5] = max(min(theta[5], 100.0), theta[4]+1.0);   // Rx
+  theta[7] = max(min(theta[7], 210.0), 70.0);   // Tx
+  theta[6] = max(min(theta[6], 220.0), theta[7]+1.0);   // Tn
+}
+// Residuals for theta, returns how many
+int HouseFit::simulate_(const double* theta, double* r)
+{
+  double p[FIT_PARAMS];
+  fromTheta_(theta, p);
+  HouseHeat house("fit", p[0], p[1], p[2], p[3], p[4], p[5], p[6], p[7]);
+  double tReset = 0;
+  int    m      = 0;
+  for (int i=0; i<n_; i++)
+  {
+    const FitSample& s = s_[i];
+    if ( s.reset )
+    {
+      house.update(true, 0.0, s.temp, double(s.call), 0.0, s.oat);
+      tReset = s.t;
+      continue;
+    }
+    const FitSample& q = s_[i-1];
+    double dt    = s.t - q.t;
+    int    steps = int(ceil(dt/FIT_STEP));
+    for (int k=0; k<steps; k++) house.update(false, dt/steps, q.temp, double(q.call), 0.0, q.oat);
+    if ( s.t-tReset >= settle_*3600.0 ) r[m++] = house.Ta() - s.temp;
+  }
+  return(m);
+}
+// Forward difference Jacobian, column k at J+k*m_, columns in parallel
+void HouseFit::jacobian_(const double* theta, const double* r0, double* J)
+{
+  std::atomic<int> next(0);
+  auto work = [&](){
+    std::vector<double> r(n_);
+    double t[FIT_PARAMS];
+    int k;
+    while ( (k = next++) < FIT_PARAMS )
+    {
+      memcpy(t, theta, sizeof(t));
+      double d = k<4 ? 1e-4 : 0.01;
+      t[k] += d;
+      simulate_(t, &r[0]);
+      for (int j=0; j<m_; j++) J[k*m_+j] = (r[j]-r0[j])/d;
+    }
+  };
+  std::vector<std::thread> pool;
+  for (int i=1; i<min(threads_, FIT_PARAMS); i++) pool.push_back(std::thread(work));
+  work();
+  for (unsigned i=0; i<pool.size(); i++) pool[i].join();
+}
+// Normal equations of the residuals, A = J'J and g = J'r
+void HouseFit::normal_(const double* J, const double* r, double A[FIT_PARAMS][FIT_PARAMS], double* g)
+{
+  for (int a=0; a<FIT_PARAMS; a++)
+  {
+    g[a] = 0;
+    for (int j=0; j<m_; j++) g[a] += J[a*m_+j]*r[j];
+    for (int b=0; b<=a; b++)
+    {
+      double s = 0;
+      for (int j=0; j<m_; j++) s += J[a*m_+j]*J[b*m_+j];
+      A[a][b] = A[b][a] = s;
+    }
+  }
+}
+// Standard errors and condition number of the data alone, J'J = A.   Scaled
+// to unit diagonal, S = D A D = V L V', the covariance is s2 D V L^-1 V' D.
+// A parameter on an eigenvector the data doesn't resolve gets HUGE_VAL, and
+// one that doesn't move the residuals at all is also unseen().
+void HouseFit::errors_(double A[FIT_PARAMS][FIT_PARAMS], const double s2)
+{
+  int    seen[FIT_PARAMS], n = 0;
+  double big = 0;
+  for (int k=0; k<FIT_PARAMS; k++) big = max(big, A[k][k]);
+  unseen_ = 0;
+  rank_   = 0;
+  for (int k=0; k<FIT_PARAMS; k++)
+  {
+    se_[k] = HUGE_VAL;
+    if ( A[k][k]>1e-12*big ) seen[n++] = k;
+    else unseen_ |= 1<<k;
+  }
+  cond_ = HUGE_VAL;
+  if ( n==0 ) return;
+  double S[FIT_PARAMS][FIT_PARAMS], V[FIT_PARAMS][FIT_PARAMS], D[FIT_PARAMS];
+  for (int a=0; a<n; a++) D[a] = 1.0/sqrt(A[seen[a]][seen[a]]);
+  for (int a=0; a<n; a++)
+    for (int b=0; b<n; b++)
+    {
+      S[a][b] = A[seen[a]][seen[b]]*D[a]*D[b];
+      V[a][b] = a==b ? 1 : 0;
+    }
+
+  // Cyclic Jacobi rotations, S to L
+  for (int sweep=0; sweep<50; sweep++)
+  {
+    double off = 0;
+    for (int a=0; a<n; a++) for (int b=a+1; b<n; b++) off += S[a][b]*S[a][b];
+    if ( off<1e-24 ) break;
+    for (int a=0; a<n; a++) for (int b=a+1; b<n; b++)
+    {
+      if ( S[a][b]==0 ) continue;
+      double phi = 0.5*atan2(2*S[a][b], S[b][b]-S[a][a]);
+      double c   = cos(phi), s = sin(phi);
+      for (int k=0; k<n; k++)
+      {
+        double ka = S[k][a], kb = S[k][b];
+        S[k][a] = c*ka - s*kb;
+        S[k][b] = s*ka + c*kb;
+        double va = V[k][a], vb = V[k][b];
+        V[k][a] = c*va - s*vb;
+        V[k][b] = s*va + c*vb;
+      }
+      for (int k=0; k<n; k++)
+      {
+        double ak = S[a][k], bk = S[b][k];
+        S[a][k] = c*ak - s*bk;
+        S[b][k] = s*ak + c*bk;
+      }
+    }
+  }
+  double lo = S[0][0], hi = S[0][0];
+  for (int e=1; e<n; e++)
+  {
+    lo = min(lo, S[e][e]);
+    hi = max(hi, S[e][e]);
+  }
+  cond_ = lo>0 ? hi/lo : HUGE_VAL;
+  for (int e=0; e<n; e++) if ( S[e][e]>1e-12*hi ) rank_++;
+  for (int a=0; a<n; a++)
+  {
+    double v = 0;
+    bool   resolved = true;
+    for (int e=0; e<n; e++)
+    {
+      if ( S[e][e]>1e-12*hi ) v += V[a][e]*V[a][e]/S[e][e];
+      else if ( V[a][e]*V[a][e]>1e-6 ) resolved = false;
+    }
+    if ( resolved ) se_[seen[a]] = sqrt(s2*v)*D[a];
+  }
+}
+// Levenberg-Marquardt from p, left in p, with a pull back to p.
+// Returns the rms of residuals and pull, F.   Also sets stdErr(), condition(),
+// rank() and unseen().
+double HouseFit::fit(double* p, const int maxIter, const bool trace)
+{
+  double  theta[FIT_PARAMS], trial[FIT_PARAMS], prior[FIT_PARAMS], w[FIT_PARAMS];
+  toTheta_(p, theta);
+  bound_(theta);
+  memcpy(prior, theta, sizeof(prior));
+  std::vector<double> r(n_), rt(n_), J(FIT_PARAMS*n_);
+  m_ = simulate_(theta, &r[0]);
+  if ( m_==0 ) return(0);
+  // The pull is per residual, so it holds its own however long the data
+  for (int k=0; k<FIT_PARAMS; k++) w[k] = double(m_)/(k<4 ? FIT_PRIOR_H : FIT_PRIOR_R)/(k<4 ? FIT_PRIOR_H : FIT_PRIOR_R);
+  double cost = 0;
+  for (int j=0; j<m_; j++) cost += r[j]*r[j];
+  for (int k=0; k<FIT_PARAMS; k++) cost += w[k]*(theta[k]-prior[k])*(theta[k]-prior[k]);
+  double lambda = 1.0;
+  double A[FIT_PARAMS][FIT_PARAMS], g[FIT_PARAMS];
+  for (int iter=0; iter<maxIter; iter++)
+  {
+    jacobian_(theta, &r[0], &J[0]);
+    normal_(&J[0], &r[0], A, g);
+    double big = 0;
+    for (int a=0; a<FIT_PARAMS; a++)
+    {
+      g[a]    += w[a]*(theta[a]-prior[a]);
+      A[a][a] += w[a];
+      big = max(big, A[a][a]);
+    }
+    bool   accepted = false;
+    double costT    = cost;
+    for (int tries=0; tries<12 && !accepted; tries++)
+    {
+      // Solve (A + lambda*diag(A)) d = -g by elimination with partial pivoting
+      double M[FIT_PARAMS][FIT_PARAMS+1];
+      for (int a=0; a<FIT_PARAMS; a++)
+      {
+        for (int b=0; b<FIT_PARAMS; b++) M[a][b] = A[a][b];
+        M[a][a]           += lambda*max(A[a][a], 1e-9*big);
+        M[a][FIT_PARAMS]   = -g[a];
+      }
+      for (int c=0; c<FIT_PARAMS; c++)
+      {
+        int piv = c;
+        for (int a=c+1; a<FIT_PARAMS; a++) if ( fabs(M[a][c])>fabs(M[piv][c]) ) piv = a;
+        for (int b=0; b<=FIT_PARAMS; b++) { double t = M[c][b]; M[c][b] = M[piv][b]; M[piv][b] = t; }
+        if ( M[c][c]==0 ) continue;
+        for (int a=c+1; a<FIT_PARAMS; a++)
+        {
+          double f = M[a][c]/M[c][c];
+          for (int b=c; b<=FIT_PARAMS; b++) M[a][b] -= f*M[c][b];
+        }
+      }
+      for (int c=FIT_PARAMS-1; c>=0; c--)
+      {
+        double s = M[c][FIT_PARAMS];
+        for (int b=c+1; b<FIT_PARAMS; b++) s -= M[c][b]*trial[b];
+        trial[c] = M[c][c]!=0 ? s/M[c][c] : 0;
+      }
+      for (int k=0; k<FIT_PARAMS; k++) trial[k] += theta[k];
+      bound_(trial);
+      simulate_(trial, &rt[0]);
+      costT = 0;
+      for (int j=0; j<m_; j++) costT += rt[j]*rt[j];
+      for (int k=0; k<FIT_PARAMS; k++) costT += w[k]*(trial[k]-prior[k])*(trial[k]-prior[k]);
+      if ( costT<cost )
+      {
+        accepted = true;
+        lambda   = max(lambda/3.0, 1e-9);
+      }
+      else lambda *= 4.0;
+    }
+    if ( !accepted ) break;
+    double gain = (cost-costT)/cost;
+    memcpy(theta, trial, sizeof(theta));
+    std::copy(rt.begin(), rt.begin()+m_, r.begin());
+    cost = costT;
+    if ( trace )
+    {
+      fromTheta_(theta, p);
+      Serial.printf("  %3d cost=%8.5f lambda=%7.1e  Ha=%6.3f Hc=%7.2f Hf=%6.3f Ho=%7.2f Rn=%5.1f Rx=%5.1f Tn=%6.1f Tx=%6.1f\n",
+        iter, sqrt(cost/m_), lambda, p[0]*86400, p[1]*86400, p[2]*86400, p[3]*86400, p[4], p[5], p[6], p[7]);
+    }
+    if ( gain<1e-7 ) break;
+  }
+  // A is of the last step, so again at the answer
+  jacobian_(theta, &r[0], &J[0]);
+  normal_(&J[0], &r[0], A, g);
+  double ss = 0;
+  for (int j=0; j<m_; j++) ss += r[j]*r[j];
+  errors_(A, ss/max(m_-FIT_PARAMS, 1));
+  fromTheta_(theta, p);
+  return(sqrt(cost/m_));
+}
+// Residual rms for p, F.   Also sets worst().
+double HouseFit::rms(const double* p)
+{
+  double theta[FIT_PARAMS];
+  toTheta_(p, theta);
+  std::vector<double> r(n_ + 1);
+  m_ = simulate_(theta, &r[0]);
+  double cost = 0;
+  worst_ = 0;
+  for (int j=0; j<m_; j++)
+  {
+    cost  += r[j]*r[j];
+    worst_ = max(worst_, fabs(r[j]));
+  }
+  return(m_>0 ? sqrt(cost/m_) : 0);
+}
+// Parameters of p the data can't support as setup() constants, bit k for p[k]:
+// a conductance more than a factor of e^FIT_MOVE_H from start, or a reset
+// curve OAT break, Rn or Rx, moved from start to within FIT_EDGE of either
+// edge of the OAT range of the records
+unsigned HouseFit::suspect(const double* p, const double* start)
+{
+  unsigned bad = 0;
+  for (int k=0; k<4; k++)
+    if ( fabs(log(p[k]/start[k]))>FIT_MOVE_H ) bad |= 1<<k;
+  for (int k=4; k<6; k++)
+    if ( p[k]!=start[k] && (fabs(p[k]-oatMin_)<=FIT_EDGE || fabs(p[k]-oatMax_)<=FIT_EDGE) ) bad |= 1<<k;
+  return(bad);
+}
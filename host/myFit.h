@@ -0,0 +1,114 @@
+/***************************************************
+  Identification of HouseHeat constants from recorded telemetry
+
+  HouseFit loads TEMP, CALL and OAT from 'stat' captures (see myReplay.h)
+  and fits the HouseHeat constructor constants Ha, Hc, Hf, Ho and the
+  boiler reset curve breaks Rn, Rx, Tn, Tx by Levenberg-Marquardt least
+  squares.   The model is HouseHeat itself, driven open loop by the
+  recorded CALL and OAT at FIT_STEP or less between records;  residuals
+  are modeled air minus recorded TEMP.   The model is reset to TEMP at
+  the start of each capture and after gaps over FIT_GAP, and residuals in
+  the first settle hours after a reset, while the unmeasured wall and
+  core temperatures find themselves, don't count.
+
+  The Jacobian is by forward differences, one simulation per parameter,
+  spread over a pool of threads.   Conductances are fitted as logs so
+  they stay positive;  the reset curve is kept ordered, Rn < Rx and
+  Tx < Tn.   Breaks outside the OAT range of the data only move Tb where
+  the data can't see.   So that those and other directions the data
+  can't resolve stay put rather than run to a bound, each parameter is
+  pulled to its starting value:  a factor of e in a conductance, or 20 F
+  in a break, costs as much as 1 F on every residual, so the pull keeps
+  its weight however much data there is.
+
+  After the fit, stdErr() is the standard error of each parameter as
+  fitted that the data alone gives, from the inverse of J'J and the
+  residual variance, without the pull.   It takes the residuals as
+  independent, which at a few seconds apart they are not, so it's a lower
+  bound.   condition() is that of J'J with its columns scaled to unit
+  diagonal;  in the thousands or more, some combination of the parameters
+  isn't in the data.   rank() counts the combinations it resolves, to
+  1e-12 of the best, and a parameter along one it doesn't has no standard
+  error, HUGE_VAL.   One that doesn't move the residuals at all is also
+  unseen() and left out of both.
+  suspect() marks what shouldn't go into setup() as found.
+
+  Class code for host application.
+
+  14-Feb-2016   Dave Gutz   Created
+ ****************************************************/
+
+#ifndef _myFit_H
+#define _myFit_H
+
+#include "application.h"
+#include "mySubs.h"
+
+#define FIT_PARAMS  8               // Ha, Hc, Hf, Ho, Rn, Rx, Tn, Tx
+#define FIT_STEP    (MODEL_DELAY/1000.0)  // Largest model step, s
+#define FIT_GAP     600.0           // Record gap that resets the model, s
+#define FIT_MAX     40000           // Records held
+#define FIT_PRIOR_H 1.0             // Pull of log conductances to the start, 1/weight
+#define FIT_PRIOR_R 20.0            // Pull of reset curve breaks to the start, F, 1/weight
+#define FIT_MOVE_H  2.0             // Largest believable move of a log conductance
+#define FIT_EDGE    1.0             // Closest believable reset curve break to the OAT range edge, F
+
+
+// One record of a capture
+struct FitSample
+{
+  double  t;        // Time, s
+  double  temp;     // TEMP, F
+  double  oat;      // OAT, F
+  int     call;     // CALL
+  bool    reset;    // Model starts over here
+};
+
+
+class HouseFit
+{
+public:
+  HouseFit(void);
+  ~HouseFit(void);
+  int     load(const char* file);
+  int     size(void){return(n_);};
+  void    settle(const double hours){settle_ = hours;};
+  void    threads(const int n){threads_ = max(n, 1);};
+  double  fit(double* p, const int maxIter, const bool trace);
+  double  rms(const double* p);
+  double  worst(void){return(worst_);};
+  int     residuals(void){return(m_);};
+  double  oatMin(void){return(oatMin_);};
+  double  oatMax(void){return(oatMax_);};
+  double  hours(void){return(hours_);};
+  double  stdErr(const int k){return(se_[k]);};    // Of log conductance, or break F
+  double  condition(void){return(cond_);};
+  int     rank(void){return(rank_);};
+  unsigned unseen(void){return(unseen_);};         // Bit k for parameter k
+  unsigned suspect(const double* p, const double* start);
+  static void nominal(double* p);
+private:
+  int     simulate_(const double* theta, double* r);
+  void    jacobian_(const double* theta, const double* r0, double* J);
+  void    toTheta_(const double* p, double* theta);
+  void    fromTheta_(const double* theta, double* p);
+  void    bound_(double* theta);
+  void    normal_(const double* J, const double* r, double A[FIT_PARAMS][FIT_PARAMS], double* g);
+  void    errors_(double A[FIT_PARAMS][FIT_PARAMS], const double s2);
+  FitSample*  s_;       // Records
+  int     n_;           // Records loaded
+  int     m_;           // Residuals counted
+  double  settle_;      // Hours after a reset before residuals count
+  int     threads_;     // Jacobian threads
+  double  worst_;       // Largest |residual| of the last rms(), F
+  double  oatMin_;      // OAT range of the records, F
+  double  oatMax_;
+  double  hours_;       // Time covered, hr
+  double  se_[FIT_PARAMS];  // Standard errors of the last fit()
+  double  cond_;        // Scaled J'J condition of the last fit()
+  int     rank_;        // Combinations the last fit() data resolves
+  unsigned unseen_;     // Parameters the last fit() data doesn't see
+};
+
+
+#endif
@@ -0,0 +1,488 @@
+/***************************************************
+  Replay of recorded 'stat' telemetry through the thermostat core
+
+  Class code for host application.
+
+  09-Feb-2016   Dave Gutz   Created
+ ****************************************************/
+#include "myReplay.h"
+#include "application.h"
+
+#define REPLAY_GAP          600.0           // Record gap that restarts the replay, s
+
+extern int verbose;
+
+// Canonical field names.   Spreadsheet headers are mapped onto these.
+struct StatKey
+{
+  const char* name;
+  unsigned    flag;
+};
+static const StatKey statKeys[] = {
+  {"CALL", STAT_CALL},  {"SET", STAT_SET},    {"TEMP", STAT_TEMP},  {"TEMPC", STAT_TEMPC},
+  {"HUM", STAT_HUM},    {"HELD", STAT_HELD},  {"T", STAT_T},        {"POT", STAT_POT},
+  {"WEB", STAT_WEB},    {"LWEB", STAT_WEB},   {"SCH", STAT_SCH},    {"OAT", STAT_OAT},
+  {"TMOD", STAT_TMOD},  {"REJH", STAT_REJH},  {"Ta_Sense", STAT_TEMP}, {"Ta_Comp", STAT_TEMPC},
+  {"Ta_Obs", STAT_TMOD}, {"Time", STAT_HM},   {"TIME", STAT_STAMP}, {NULL, 0}
+};
+
+static unsigned statFlag(const char* key, const int klen)
+{
+  for (int i=0; statKeys[i].name; i++)
+    if ( statKeys[i].name[0]==key[0] && strncmp(statKeys[i].name, key, klen)==0 && statKeys[i].name[klen]=='\0' )
+      return(statKeys[i].flag);
+  return(0);
+}
+
+// Leading decimal number of p, as atof without the locale and exponent
+// handling that made it most of a parse.   Falls back to atof for those.
+static double number(const char* p)
+{
+  const char* s = p;
+  while ( *p==' ' ) p++;
+  bool   neg = *p=='-';
+  if ( *p=='-' || *p=='+' ) p++;
+  double v = 0, div = 1;
+  for ( ; *p>='0' && *p<='9'; p++) v = v*10 + (*p-'0');
+  if ( *p=='.' )
+    for (p++; *p>='0' && *p<='9' && div<1e15; p++, div*=10) v = v*10 + (*p-'0');
+  if ( *p=='e' || *p=='E' || (*p>='0' && *p<='9') ) return(atof(s));
+  return((neg ? -v : v)/div);
+}
+
+// Value of a JSON string member, not unescaped.   Returns length or -1.
+static int jsonString(const char* line, const char* name, const char** val)
+{
+  char key[24];
+  int  n = strlen(name);
+  key[0] = '"';
+  memcpy(key+1, name, n);
+  memcpy(key+n+1, "\":\"", 4);
+  const char* p = strstr(line, key);
+  if ( !p ) return(-1);
+  p += n+4;
+  const char* e = strchr(p, '"');
+  if ( !e ) return(-1);
+  *val = p;
+  return(e-p);
+}
+
+// hh:mm at p, as minute of day, or -1
+static int hourMinute(const char* p)
+{
+  int h, m;
+  if ( sscanf(p, "%d:%d", &h, &m)!=2 || h<0 || h>23 || m<0 || m>59 ) return(-1);
+  return(h*60+m);
+}
+
+
+// Digits p[0..n) as a number, or -1
+static int digits(const char* p, const int n)
+{
+  int v = 0;
+  for (int i=0; i<n; i++)
+  {
+    if ( p[i]<'0' || p[i]>'9' ) return(-1);
+    v = v*10 + p[i]-'0';
+  }
+  return(v);
+}
+
+// published_at, yyyy-mm-ddThh:mm:ss[.fff]Z, as Unix s.   Fixed fields and a
+// civil day count rather than sscanf and timegm, which dominated ingest.
+bool isoStamp(const char* v, const int n, double* stamp)
+{
+  if ( n<19 || v[4]!='-' || v[7]!='-' || v[10]!='T' || v[13]!=':' || v[16]!=':' ) return(false);
+  int y = digits(v, 4), mo = digits(v+5, 2), d = digits(v+8, 2);
+  int h = digits(v+11, 2), mi = digits(v+14, 2), sec = digits(v+17, 2);
+  if ( y<0 || mo<1 || mo>12 || d<1 || d>31 || h<0 || h>23 || mi<0 || mi>59 || sec<0 || sec>60 ) return(false);
+  double frac = 0, per = 0.1;
+  for (int i=20; i<n && v[19]=='.' && v[i]>='0' && v[i]<='9'; i++, per/=10) frac += (v[i]-'0')*per;
+  // Days from 1970-01-01 in the proleptic Gregorian calendar, years from March
+  y -= mo<=2;
+  int era = (y>=0 ? y : y-399)/400;
+  int yoe = y - era*400;
+  int doy = (153*(mo>2 ? mo-3 : mo+9) + 2)/5 + d-1;
+  int doe = yoe*365 + yoe/4 - yoe/100 + doy;
+  long days = long(era)*146097 + doe - 719468;
+  *stamp = days*86400.0 + h*3600 + mi*60 + sec + frac;
+  return(true);
+}
+
+
+// class StatRecord
+// constructors
+StatRecord::StatRecord(void)
+  : fields(0), stamp(0), minute(0), call(0), set(0), temp(0), tempc(0), hum(0), held(0), T(0),
+  pot(0), web(0), sch(0), oat(0), tmod(0), rejh(0), duty(0), starts(0), setFrac_(false), ncols_(0)
+{
+  coreid[0] = '\0';
+  for (int i=0; i<TELEM_SIGNALS; i++) lo[i] = hi[i] = sd[i] = 0;
+}
+// functions
+// Parse one line.   False if it holds no record (blank, header, truncated).
+bool StatRecord::parse(const char* line)
+{
+  fields    = 0;
+  setFrac_  = false;
+  coreid[0] = '\0';
+  const char* data;
+  int n = jsonString(line, "data", &data);
+  if ( n<0 )
+  {
+    if ( strchr(line, '\t') ) return(parseTabs_(line));
+    data = line;
+    n    = strcspn(line, "\r\n");
+  }
+  else
+  {
+    const char* v;
+    int vn = jsonString(line, "published_at", &v);
+    if ( vn>0 && isoStamp(v, vn, &stamp) ) fields |= STAT_STAMP;
+    vn = jsonString(line, "coreid", &v);
+    if ( vn>0 && vn<(int)sizeof(coreid) )
+    {
+      memcpy(coreid, v, vn);
+      coreid[vn] = '\0';
+    }
+  }
+  TelemetryRecord t;
+  if ( telemDecode(data, n, &t) ) telemetry_(t);
+  else if ( !parseData_(data, n) ) return(false);
+  return(has(STAT_TEMP));
+}
+
+// Binary record, every field but the stamp
+void StatRecord::telemetry_(const TelemetryRecord& t)
+{
+  minute    = t.minute;
+  call      = (t.flags & TELEM_CALL)!=0;
+  set       = t.set/100.0;
+  temp      = t.temp/100.0;
+  tempc     = t.tempComp/100.0;
+  hum       = t.hum;
+  held      = (t.flags & TELEM_HELD)!=0;
+  T         = t.T/1000.0;
+  pot       = t.pot;
+  web       = t.web;
+  sch       = t.schd;
+  oat       = t.oat/10.0;
+  tmod      = t.tmod/100.0;
+  rejh      = t.rejh/1000.0;
+  setFrac_  = true;
+  if ( t.version>1 )
+  {
+    const double mean[TELEM_SIGNALS] = {temp, tempc, tmod, rejh};
+    for (int i=0; i<TELEM_SIGNALS; i++)
+    {
+      double per = i<3 ? 0.01 : 0.001;
+      lo[i] = mean[i] - t.lo[i]*per;
+      hi[i] = mean[i] + t.hi[i]*per;
+      sd[i] = t.sd[i]*per;
+    }
+    duty    = double(t.duty)/TELEM_DUTY;
+    starts  = t.starts;
+    fields |= STAT_WINDOW;
+  }
+  fields   |= STAT_HM | STAT_CALL | STAT_SET | STAT_TEMP | STAT_TEMPC | STAT_HUM | STAT_HELD | STAT_T |
+              STAT_POT | STAT_WEB | STAT_SCH | STAT_OAT | STAT_TMOD | STAT_REJH;
+}
+
+// Fields are separated by '|' or, in the early format, "-->".   Each is
+// hh:mm or KEY value.
+bool StatRecord::parseData_(const char* data, const int n)
+{
+  char buf[512];
+  int  len = min(n, (int)sizeof(buf)-1);
+  memcpy(buf, data, len);
+  buf[len] = '\0';
+  char* arrow = strstr(buf, "-->");
+  if ( arrow ) memcpy(arrow, "|  ", 3);
+  char* save;
+  for (char* tok=strtok_r(buf, "|", &save); tok; tok=strtok_r(NULL, "|", &save))
+  {
+    while ( *tok==' ' ) tok++;
+    if ( *tok=='\0' ) continue;
+    if ( isdigit(*tok) )
+    {
+      int m = hourMinute(tok);
+      if ( m>=0 )
+      {
+        minute  = m;
+        fields |= STAT_HM;
+      }
+      continue;
+    }
+    char* key = tok;
+    while ( *tok && *tok!=' ' ) tok++;
+    int klen = tok-key;
+    while ( *tok==' ' ) tok++;
+    if ( *tok && !field_(key, klen, tok) ) windowField_(key, klen, tok);
+  }
+  return(fields!=0);
+}
+
+// Tab separated spreadsheet export.   The header line names the columns.
+bool StatRecord::parseTabs_(const char* line)
+{
+  char buf[256];
+  strncpy(buf, line, sizeof(buf)-1);
+  buf[sizeof(buf)-1] = '\0';
+  buf[strcspn(buf, "\r\n")] = '\0';
+  char* save;
+  int   col = 0;
+  bool  header = !isdigit(buf[0]);
+  if ( header ) ncols_ = 0;
+  for (char* tok=strtok_r(buf, "\t", &save); tok && col<16; tok=strtok_r(NULL, "\t", &save), col++)
+  {
+    if ( header )
+    {
+      cols_[col] = statFlag(tok, strlen(tok));
+      ncols_     = col+1;
+      continue;
+    }
+    if ( col>=ncols_ ) break;
+    if ( cols_[col]==STAT_HM )
+    {
+      int m = hourMinute(tok);
+      if ( m>=0 )
+      {
+        minute  = m;
+        fields |= STAT_HM;
+      }
+    }
+    else
+    {
+      for (int i=0; statKeys[i].name; i++)
+        if ( statKeys[i].flag==cols_[col] )
+        {
+          field_(statKeys[i].name, strlen(statKeys[i].name), tok);
+          break;
+        }
+    }
+  }
+  return(!header && has(STAT_TEMP));
+}
+
+bool StatRecord::field_(const char* key, const int klen, const char* val)
+{
+  unsigned f = statFlag(key, klen);
+  double   v = number(val);
+  switch ( f )
+  {
+    case STAT_CALL:   call  = int(v);   break;
+    case STAT_SET:    set   = v; setFrac_ = (strchr(val, '.')!=NULL); break;
+    case STAT_TEMP:   temp  = v;        break;
+    case STAT_TEMPC:  tempc = v;        break;
+    case STAT_HUM:    hum   = int(v);   break;
+    case STAT_HELD:   held  = int(v);   break;
+    case STAT_T:      T     = v;        break;
+    case STAT_POT:    pot   = int(v);   break;
+    case STAT_WEB:    web   = int(v);   break;
+    case STAT_SCH:    sch   = int(v);   break;
+    case STAT_OAT:    oat   = v;        break;
+    case STAT_TMOD:   tmod  = v;        break;
+    case STAT_REJH:   rejh  = v;        break;
+    case STAT_STAMP:  stamp = v;        break;
+    default:          return(false);
+  }
+  fields |= f;
+  return(true);
+}
+
+// DUTY, STARTS, or a window spread as telemText() writes them, TEMPLO for one
+bool StatRecord::windowField_(const char* key, const int klen, const char* val)
+{
+  static const char* name[TELEM_SIGNALS] = {"TEMP", "TEMPC", "TMOD", "REJH"};
+  double v = number(val);
+  if ( klen==4 && strncmp(key, "DUTY", 4)==0 ) duty = v;
+  else if ( klen==6 && strncmp(key, "STARTS", 6)==0 ) starts = int(v);
+  else
+  {
+    int i = 0;
+    while ( i<TELEM_SIGNALS && !(klen==(int)strlen(name[i])+2 && strncmp(key, name[i], klen-2)==0) ) i++;
+    if ( i==TELEM_SIGNALS ) return(false);
+    const char* kind = key + klen-2;
+    if ( strncmp(kind, "LO", 2)==0 ) lo[i] = v;
+    else if ( strncmp(kind, "HI", 2)==0 ) hi[i] = v;
+    else if ( strncmp(kind, "SD", 2)==0 ) sd[i] = v;
+    else return(false);
+  }
+  fields |= STAT_WINDOW;
+  return(true);
+}
+
+// Control setpoint.   Since SET went to one decimal it has been published
+// as callCount+set-HYST; callCount is taken as CALL.
+int StatRecord::setpoint(void) const
+{
+  if ( setFrac_ ) return(int(roundf(set + HYST - call)));
+  return(int(roundf(set)));
+}
+
+
+// class Divergence
+void Divergence::add(const double recorded, const double replayed, const double t)
+{
+  double e = replayed - recorded;
+  n++;
+  sum   += e;
+  sumSq += e*e;
+  if ( fabs(e)>0.5 ) mismatches++;
+  if ( fabs(e)>worst )
+  {
+    worst   = fabs(e);
+    worstAt = t;
+  }
+}
+void Divergence::reset(void)
+{
+  n = 0; sum = 0; sumSq = 0; worst = 0; worstAt = 0; mismatches = 0;
+}
+void Divergence::print(const char* name)
+{
+  if ( n==0 )
+  {
+    Serial.printf("  %-6s      -  not recorded\n", name);
+    return;
+  }
+  Serial.printf("  %-6s %6lu %9.4f %9.4f %9.4f %8.2f %6.2f%%\n", name, n, sum/n, sqrt(sumSq/n),
+    worst, worstAt, 100.0*mismatches/n);
+}
+
+
+// class Replay
+// constructors
+Replay::Replay(const HouseHeat& embMod, const double Kv, const double tau)
+  : init_(embMod), embMod_(embMod), rateFilter_(double(FILTER_DELAY)/1000.0, tau, -0.1, 0.1),
+  filterTask_(-1), modelTask_(-1), controlTask_(-1), Kv_(Kv), tau_(tau), settle_(0.0), trace_(false)
+{
+  reset();
+}
+// functions
+void Replay::reset(void)
+{
+  embMod_     = init_;
+  rateFilter_ = RateLagExpT<double, VARIABLE_STEP>(double(FILTER_DELAY)/1000.0, tau_, -0.1, 0.1);
+  started_    = false;
+  RESET_      = 1;
+  t0_         = 0.0;
+  now_        = 0UL;
+  Ta_Sense_   = 0.0;
+  TaRat_Obs_  = 0.0;
+  Ta_Obs_     = 0.0;
+  rejectHeat_ = 0.0;
+  tempComp_   = 0.0;
+  callCount_  = 0.0;
+  call_       = false;
+  records_    = 0UL;
+  gaps_       = 0UL;
+  tempc.reset();
+  tmod.reset();
+  rejh.reset();
+  call.reset();
+}
+
+// Advance to the record's time and compare.   False if the record could not be placed in time.
+bool Replay::add(const StatRecord& r)
+{
+  double t;
+  if ( r.has(STAT_STAMP) ) t = r.stamp;
+  else if ( !started_ ) t = r.minute*60.0;
+  else
+  {
+    // No stamp:  assume the publish period unless hh:mm says otherwise
+    t = t0_ + now_/1000.0 + STAT_PERIOD;
+    if ( r.has(STAT_HM) )
+    {
+      double day = floor((t-30.0)/86400.0)*86400.0;
+      double hm  = day + r.minute*60.0;
+      if ( hm < t-43200.0 ) hm += 86400.0;
+      if ( fabs(hm-t)>90.0 ) t = hm;
+    }
+  }
+  if ( !started_ )
+  {
+    t0_       = t;
+    started_  = true;
+    prev_     = r;
+    Ta_Sense_ = r.temp;
+    Ta_Obs_   = r.has(STAT_TMOD) ? r.tmod : r.temp;
+    callCount_= r.call;
+    call_     = r.call;
+    // Task clocks start with everything due at once, as after boot
+    sched_        = TaskScheduler();
+    filterTask_   = sched_.add("filter",  FILTER_DELAY,  0, 0, SCHED_FREE, 0UL);
+    modelTask_    = sched_.add("model",   MODEL_DELAY,   0, 0, SCHED_FREE, 0UL);
+    controlTask_  = sched_.add("control", CONTROL_DELAY, 0, 0, SCHED_FREE, 0UL);
+  }
+  if ( t < t0_ + now_/1000.0 - 1.0 ) return(false);          // Out of order
+  if ( t - (t0_ + now_/1000.0) > REPLAY_GAP )
+  {
+    // Outage.   The unit likely rebooted; start the dynamics over.
+    gaps_++;
+    RESET_    = 1;
+    prev_     = r;
+  }
+  run_((unsigned long)((t - t0_)*1000.0 + 0.5), r);
+  records_++;
+
+  double h = now_/3600000.0;
+  if ( h>=settle_ )
+  {
+    if ( r.has(STAT_TEMPC) ) tempc.add(r.tempc, tempComp_, h);
+    if ( r.has(STAT_TMOD) ) tmod.add(r.tmod, Ta_Obs_, h);
+    if ( r.has(STAT_REJH) ) rejh.add(r.rejh, rejectHeat_*200, h);
+    if ( r.has(STAT_CALL) ) call.add(r.call, call_, h);
+  }
+  if ( trace_ )
+    Serial.printf("%8.4f,%7.3f,%7.3f,%7.3f,%7.3f,%7.3f,%7.3f,%d,%d\n", h, r.temp, r.tempc, tempComp_,
+      r.tmod, Ta_Obs_, rejectHeat_*200, r.call, call_);
+  prev_ = r;
+  return(true);
+}
+
+// Run the loop() tasks from now_ to 'until' on the record timeline
+void Replay::run_(const unsigned long until, const StatRecord& r)
+{
+  unsigned long from = now_;
+  int set = r.setpoint();
+  while ( true )
+  {
+    sched_.poll(now_);
+    // Sensed temperature straight-line between records
+    double f  = until>from ? double(now_-from)/double(until-from) : 1.0;
+    Ta_Sense_ = prev_.temp + (r.temp - prev_.temp)*f;
+    double OAT = r.has(STAT_OAT) ? r.oat : 30.0;
+    if ( sched_.ready(modelTask_) )
+    {
+      double T    = RESET_ ? MODEL_DELAY/1000 : sched_.elapsed(modelTask_)/1000.0;
+      rejectHeat_ = houseTrack(RESET_, double(prev_.call), Ta_Sense_, Ta_Obs_, T);
+      TaRat_Obs_  = embMod_.update(RESET_, T, Ta_Sense_, double(prev_.call), rejectHeat_, OAT);
+      Ta_Obs_     = embMod_.Ta();
+      tempComp_   = Ta_Sense_ + TaRat_Obs_*Kv_;
+    }
+    if ( sched_.ready(filterTask_) )
+    {
+      double T    = RESET_ ? FILTER_DELAY/1000 : sched_.elapsed(filterTask_)/1000.0;
+      rateFilter_.calculate(Ta_Sense_, RESET_, T);
+      RESET_      = 0;
+    }
+    if ( sched_.ready(controlTask_) ) call_ = controlLaw(call_, set, tempComp_, &callCount_);
+    unsigned long step = sched_.untilNext(now_);
+    if ( now_>=until || now_+step>until ) break;
+    now_ += max(step, 1UL);
+  }
+  now_ = until;
+}
+
+void Replay::print(void)
+{
+  Serial.printf("replay: records=%lu span=%7.2f hr gaps=%lu settle=%4.2f hr\n", records_, hours(),
+    gaps_, settle_);
+  Serial.printf("  signal      n      mean       rms     worst  at (hr)   >0.5\n");
+  tempc.print("TEMPC");
+  tmod.print("TMOD");
+  rejh.print("REJH");
+  call.print("CALL");
+}
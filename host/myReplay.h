@@ -0,0 +1,167 @@
+/***************************************************
+  Replay of recorded 'stat' telemetry through the thermostat core
+
+  StatRecord parses one line of a capture in Data/.   All the formats
+  the thermostat has published are accepted:
+      {"data":"|hh:mm|CALL 1|SET 69.5|TEMP ...|","published_at":...}   JSON wrapped
+      |hh:mm|CALL 1|SET 69.5|TEMP ...|                                 bare
+      {"data":"hh:mm--> CALL 0 | SET 68 | TEMP ...","published_at":...} early
+      Time<TAB>CALL<TAB>SET<TAB>Ta_Sense ...                           spreadsheet export
+      {"data":"AQEy...","published_at":...}                            TelemetryRecord
+      {"data":"|hh:mm|CALL 1|...|SEQ 12|TIME 1455...|",...}             statlog, RingLog::format
+  Fields not in a record are flagged absent rather than zeroed.   A
+  version 2 TelemetryRecord, or its text from hostDecode, also carries the
+  publish window (STAT_WINDOW).   The
+  TIME of a statlog record, when it was taken, overrides published_at,
+  when it was delivered.
+
+  Replay streams records through the rate filter, houseTrack, the embedded
+  HouseHeat model and the control law on the same task periods as loop(),
+  stepping a TaskScheduler on the record timeline.   Sensed temperature is
+  interpolated between records and the recorded CALL drives the model, so
+  the model sees the heat the house really got.   At each record the
+  recomputed TEMPC, TMOD, REJH and CALL are compared with the recorded ones.
+
+  Class code for host application.
+
+  09-Feb-2016   Dave Gutz   Created
+ ****************************************************/
+
+#ifndef _myReplay_H
+#define _myReplay_H
+
+#include "application.h"
+#include "mySubs.h"
+#include "myFilters.h"
+#include "myScheduler.h"
+#include "myTelemetry.h"
+
+// StatRecord field flags
+#define STAT_CALL   0x0001
+#define STAT_SET    0x0002
+#define STAT_TEMP   0x0004
+#define STAT_TEMPC  0x0008
+#define STAT_HUM    0x0010
+#define STAT_HELD   0x0020
+#define STAT_T      0x0040
+#define STAT_POT    0x0080
+#define STAT_WEB    0x0100
+#define STAT_SCH    0x0200
+#define STAT_OAT    0x0400
+#define STAT_TMOD   0x0800
+#define STAT_REJH   0x1000
+#define STAT_STAMP  0x2000          // published_at or TIME present
+#define STAT_HM     0x4000          // hh:mm present
+#define STAT_WINDOW 0x8000          // DUTY, STARTS and the window spreads present
+
+#define STAT_PERIOD 30.0            // Publish period assumed when there is no published_at, s
+
+
+bool isoStamp(const char* v, const int n, double* stamp);
+
+
+class StatRecord
+{
+public:
+  StatRecord(void);
+  bool    parse(const char* line);
+  bool    has(const unsigned f) const {return((fields & f)==f);};
+  int     setpoint(void) const;
+  unsigned  fields;       // STAT_ flags of fields present
+  double    stamp;        // published_at or TIME, Unix s
+  int       minute;       // hh:mm as minute of day
+  int       call;         // CALL
+  double    set;          // SET as published
+  double    temp;         // TEMP, sensed, F
+  double    tempc;        // TEMPC, compensated, F
+  int       hum;          // HUM, %
+  int       held;         // HELD
+  double    T;            // T, control update time, s
+  int       pot;          // POT, F
+  int       web;          // WEB or LWEB, F
+  int       sch;          // SCH, F
+  double    oat;          // OAT, F
+  double    tmod;         // TMOD, embedded model air temp, F
+  double    rejh;         // REJH, rejection heat *200
+  double    duty;         // DUTY, CALL fraction of the window
+  int       starts;       // STARTS, heat calls begun in the window
+  double    lo[TELEM_SIGNALS];  // Window min of TEMP, TEMPC, TMOD, REJH, whose values are then window means
+  double    hi[TELEM_SIGNALS];  // Window max
+  double    sd[TELEM_SIGNALS];  // Window standard deviation
+  char      coreid[25];   // Device id
+private:
+  bool      parseData_(const char* data, const int n);
+  bool      parseTabs_(const char* line);
+  void      telemetry_(const TelemetryRecord& t);
+  bool      field_(const char* key, const int klen, const char* val);
+  bool      windowField_(const char* key, const int klen, const char* val);
+  bool      setFrac_;     // SET published as callCount+set-HYST
+  unsigned  cols_[16];    // Spreadsheet column flags from header line
+  int       ncols_;       // Spreadsheet columns, 0 before a header line
+};
+
+
+// Divergence of one recomputed channel from the recording
+class Divergence
+{
+public:
+  Divergence(void){reset();};
+  void    add(const double recorded, const double replayed, const double t);
+  void    reset(void);
+  void    print(const char* name);
+  unsigned long n;        // Comparisons
+  double    sum;          // Sum of replayed - recorded
+  double    sumSq;        // Sum of squares
+  double    worst;        // Largest |replayed - recorded|
+  double    worstAt;      // Hours into replay of worst
+  unsigned long mismatches; // Samples differing by more than half a unit (CALL)
+};
+
+
+class Replay
+{
+public:
+  Replay(const HouseHeat& embMod, const double Kv, const double tau);
+  void    reset(void);
+  bool    add(const StatRecord& r);
+  void    print(void);
+  void    settle(const double hours){settle_ = hours;};
+  void    trace(const bool on){trace_ = on;};
+  Divergence  tempc;      // TEMPC
+  Divergence  tmod;       // TMOD
+  Divergence  rejh;       // REJH
+  Divergence  call;       // CALL
+  unsigned long records(void){return(records_);};
+  unsigned long gaps(void){return(gaps_);};
+  double  hours(void){return(now_/3600000.0);};
+private:
+  void    run_(const unsigned long until, const StatRecord& r);
+  HouseHeat     init_;        // Model as constructed, restored by reset()
+  HouseHeat     embMod_;      // Embedded model
+  RateLagExpT<double, VARIABLE_STEP> rateFilter_;  // Rate filter
+  TaskScheduler sched_;       // Task timing on the record timeline
+  int           filterTask_;
+  int           modelTask_;
+  int           controlTask_;
+  double        Kv_;          // Rate gain, F/(F/sec)
+  double        tau_;         // Rate filter time constant, s
+  double        settle_;      // Hours before comparisons count
+  bool          trace_;       // Print each comparison
+  bool          started_;     // First record seen
+  int           RESET_;       // Dynamic initialization flag
+  double        t0_;          // Record time of replay start, s
+  unsigned long now_;         // Replay time, ms
+  StatRecord    prev_;        // Last record
+  double        Ta_Sense_;    // Sensed temp, F
+  double        TaRat_Obs_;   // Modeled rate of change of temp, F/sec
+  double        Ta_Obs_;      // Modeled air temp, F
+  double        rejectHeat_;  // Rejection heat, F/sec
+  double        tempComp_;    // Compensated temp, F
+  double        callCount_;   // Control persistence
+  bool          call_;        // Recomputed heat call
+  unsigned long records_;     // Records replayed
+  unsigned long gaps_;        // Record gaps over 10 minutes, re-initialized
+};
+
+
+#endif
@@ -183,46 +183,107 @@ static const uint16_t alphafonttable[] =  {
 0b0011111111111111,
 
 };
+// Note c as the setting wanted, and send it unless *cache says the device
+// has it already.   A failed command is unknown, so the next request, or
+// resync(), sends it again.
+boolean Adafruit_LEDBackpack::command(uint8_t c, uint8_t *want, uint8_t *cache) {
+  *want = c;
+  if (*cache == c) {
+    cmdSkipCount++;
+    return true;
+  }
+  Wire.beginTransmission(i2c_addr);
+  Wire.write(c);
+  lastStatus = Wire.endTransmission();
+  boolean ok = lastStatus == 0;
+  *cache = ok ? c : 0;
+  return ok;
+}
+
 void Adafruit_LEDBackpack::setBrightness(uint8_t b) {
   if (b > 15) b = 15;
-  Wire.beginTransmission(i2c_addr);
-  Wire.write(HT16K33_CMD_BRIGHTNESS | b);
-  Wire.endTransmission();
+  command(HT16K33_CMD_BRIGHTNESS | b, &wantBrightness, &brightness);
 }
 
 void Adafruit_LEDBackpack::blinkRate(uint8_t b) {
-  Wire.beginTransmission(i2c_addr);
   if (b > 3) b = 0; // turn off if not sure
 
-  Wire.write(HT16K33_BLINK_CMD | HT16K33_BLINK_DISPLAYON | (b << 1));
-  Wire.endTransmission();
+  command(HT16K33_BLINK_CMD | HT16K33_BLINK_DISPLAYON | (b << 1), &wantBlink, &blink);
+}
+
+void Adafruit_LEDBackpack::setOscillator(boolean on) {
+  command(on ? 0x21 : 0x20, &wantOscillator, &oscillator);
 }
 
-Adafruit_LEDBackpack::Adafruit_LEDBackpack(void) {
+Adafruit_LEDBackpack::Adafruit_LEDBackpack(void)
+  : i2c_addr(0x70), sentValid(false), oscillator(0), blink(0), brightness(0),
+    wantOscillator(0), wantBlink(0), wantBrightness(0), lastStatus(0),
+    flushCount(0), skipCount(0), byteCount(0), cmdSkipCount(0) {
 }
 
 void Adafruit_LEDBackpack::begin(uint8_t _addr = 0x70) {
   i2c_addr = _addr;
+  sentValid = false;  // display RAM is random at power up
+  oscillator = blink = brightness = 0;
+  wantOscillator = wantBlink = wantBrightness = 0;
+  flushCount = skipCount = byteCount = cmdSkipCount = 0;
 
   Wire.begin();
 
-  Wire.beginTransmission(i2c_addr);
-  Wire.write(0x21);  // turn on oscillator
-  Wire.endTransmission();
+  setOscillator(true);  // turn on oscillator
   blinkRate(HT16K33_BLINK_OFF);
 
   setBrightness(15); // max brightness
 }
 
 void Adafruit_LEDBackpack::writeDisplay(void) {
-  Wire.beginTransmission(i2c_addr);
-  Wire.write((uint8_t)0x00); // start at address $00
-
+  uint8_t image[16];
   for (uint8_t i=0; i<8; i++) {
-    Wire.write(displaybuffer[i] & 0xFF);
-    Wire.write(displaybuffer[i] >> 8);
+    image[2*i]   = displaybuffer[i] & 0xFF;
+    image[2*i+1] = displaybuffer[i] >> 8;
+  }
+  flushCount++;
+
+  // Send the run from the first to the last changed byte;  the display
+  // RAM address auto-increments, so it starts at that byte's address
+  uint8_t first = 0, last = 16;
+  if (sentValid) {
+    while (first < 16 && image[first] == sent[first]) first++;
+    if (first == 16) {
+      skipCount++;
+      return;
+    }
+    while (image[last-1] == sent[last-1]) last--;
   }
-  Wire.endTransmission();
+
+  Wire.beginTransmission(i2c_addr);
+  Wire.write(first); // start at address $first
+  for (uint8_t i=first; i<last; i++) {
+    Wire.write(image[i]);
+  }
+  byteCount += last - first;
+  lastStatus = Wire.endTransmission();
+  if (lastStatus == 0) {
+    memcpy(sent, image, sizeof(sent));
+    sentValid = true;
+  } else {
+    sentValid = false;  // unknown what arrived, send it all next time
+  }
+}
+
+void Adafruit_LEDBackpack::invalidate(void) {
+  sentValid = false;
+}
+
+// The device may have lost or garbled anything;  send it all again, each
+// setting as last asked for, whether or not that got through
+void Adafruit_LEDBackpack::resync(void) {
+  oscillator = blink = brightness = 0;
+  sentValid = false;
+  if (wantOscillator) command(wantOscillator, &wantOscillator, &oscillator);
+  if (wantBlink) command(wantBlink, &wantBlink, &blink);
+  if (wantBrightness) command(wantBrightness, &wantBrightness, &brightness);
+  writeDisplay();
 }
 
 void Adafruit_LEDBackpack::clear(void) {
@@ -335,9 +396,48 @@ void Adafruit_8x16matrix::drawPixel(int16_t x, int16_t y, uint16_t color) {
 
 /******************************* 8x8 MATRIX OBJECT */
 
+#ifndef __AVR__
+#include "glcdfont.cpp"
+
+// Frames of the characters in GLYPH_CHARS as drawChar() and drawPixel()
+// at rotation 0 leave displaybuffer:  column i of the 5x7 font is bit
+// (i+7)%8 of each row.   constexpr, so they are flash, not built at boot.
+#define GLYPH_CHARS "0123456789STOH=- "
+
+static constexpr uint16_t glyphRow(uint8_t c, uint8_t r) {
+  return ((font[c*5+0] >> r) & 1) << 7 | ((font[c*5+1] >> r) & 1) << 0 |
+         ((font[c*5+2] >> r) & 1) << 1 | ((font[c*5+3] >> r) & 1) << 2 |
+         ((font[c*5+4] >> r) & 1) << 3;
+}
+#define GLYPH(c) { glyphRow(c, 0), glyphRow(c, 1), glyphRow(c, 2), glyphRow(c, 3), \
+                   glyphRow(c, 4), glyphRow(c, 5), glyphRow(c, 6), glyphRow(c, 7) }
+
+static constexpr uint16_t glyphs[][8] = {
+  GLYPH('0'), GLYPH('1'), GLYPH('2'), GLYPH('3'), GLYPH('4'), GLYPH('5'),
+  GLYPH('6'), GLYPH('7'), GLYPH('8'), GLYPH('9'), GLYPH('S'), GLYPH('T'),
+  GLYPH('O'), GLYPH('H'), GLYPH('='), GLYPH('-'), GLYPH(' ')
+};
+static_assert(sizeof(glyphs)/sizeof(glyphs[0]) == sizeof(GLYPH_CHARS)-1,
+  "a glyph for each of GLYPH_CHARS");
+#endif
+
 Adafruit_8x8matrix::Adafruit_8x8matrix(void) : Adafruit_GFX(8, 8) {
 }
 
+void Adafruit_8x8matrix::showChar(uint8_t c) {
+#ifndef __AVR__
+  const char *g = c ? strchr(GLYPH_CHARS, c) : NULL;
+  if (g && getRotation() == 0 && textsize == 1 && textcolor &&
+      (textbgcolor == textcolor || !textbgcolor)) {
+    memcpy(displaybuffer, glyphs[g - GLYPH_CHARS], sizeof(displaybuffer));
+    return;
+  }
+#endif
+  clear();
+  setCursor(0, 0);
+  write(c);
+}
+
 void Adafruit_8x8matrix::drawPixel(int16_t x, int16_t y, uint16_t color) {
   if ((y < 0) || (y >= 8)) return;
   if ((x < 0) || (x >= 8)) return;
@@ -66,12 +66,34 @@ class Adafruit_LEDBackpack {
   void blinkRate(uint8_t b);
   void writeDisplay(void);
   void clear(void);
+  void setOscillator(boolean on);
+  void invalidate(void);  // next writeDisplay() sends the whole buffer
+  void resync(void);      // resend all the state, as after a bus error
 
   uint16_t displaybuffer[8];
 
+  // writeDisplay() sends only the bytes that differ from what it sent
+  // last, or nothing when none do.   Counts, since begin():
+  uint32_t flushes(void) { return flushCount; }         // writeDisplay() calls
+  uint32_t flushesSkipped(void) { return skipCount; }   // of those that sent nothing
+  uint32_t bytesSent(void) { return byteCount; }        // display RAM bytes sent
+  // setBrightness(), blinkRate() and setOscillator() send nothing when
+  // the device already has that setting
+  uint32_t commandsSkipped(void) { return cmdSkipCount; }
+  uint8_t status(void) { return lastStatus; }  // of the last transmission, 0 ok
+
   void init(uint8_t a);
  protected:
   uint8_t i2c_addr;
+ private:
+  boolean command(uint8_t c, uint8_t *want, uint8_t *cache);
+
+  uint8_t sent[16];       // display RAM as last sent
+  boolean sentValid;      // sent[] matches the device
+  uint8_t oscillator, blink, brightness;  // commands as last sent, 0 unknown
+  uint8_t wantOscillator, wantBlink, wantBrightness;  // commands as last asked for, 0 never
+  uint8_t lastStatus;
+  uint32_t flushCount, skipCount, byteCount, cmdSkipCount;
 };
 
 class Adafruit_AlphaNum4 : public Adafruit_LEDBackpack {
@@ -110,6 +132,11 @@ class Adafruit_8x8matrix : public Adafruit_LEDBackpack, public Adafruit_GFX {
   Adafruit_8x8matrix(void);
 
   void drawPixel(int16_t x, int16_t y, uint16_t color);
+  // The frame of character c alone at the origin, like clear(),
+  // setCursor(0, 0) and write(c).   Copied from a table built at compile
+  // time for the characters the thermostat shows at text size 1, drawn
+  // if not one.
+  void showChar(uint8_t c);
 
  private:
 };
@@ -8,9 +8,15 @@
  #define PROGMEM
 #endif
 
-// Standard ASCII 5x7 font
+// Standard ASCII 5x7 font.   constexpr where it isn't PROGMEM, so glyphs
+// can be built from it at compile time.
+#ifdef __AVR__
+ #define FONT5X7_CONST const
+#else
+ #define FONT5X7_CONST constexpr
+#endif
 
-static const unsigned char font[] PROGMEM = {
+static FONT5X7_CONST unsigned char font[] PROGMEM = {
         0x00, 0x00, 0x00, 0x00, 0x00,
 	0x3E, 0x5B, 0x4F, 0x5B, 0x3E,
 	0x3E, 0x6B, 0x4F, 0x6B, 0x3E,
@@ -0,0 +1,145 @@
+/***************************************************
+  Prioritized transactions on the shared I2C bus
+
+  Class code for embedded application.
+
+  20-Feb-2016   Dave Gutz   Created
+ ****************************************************/
+#include "myBus.h"
+#include "application.h"
+
+// class BusDevice
+// constructors
+BusDevice::BusDevice()
+  : name(""), addr(0), priority(0), jobs(0UL), errors(0UL), coalesced(0UL), held(0UL),
+  waitSum(0.0), waitMax(0UL), busySum(0.0), busyMax(0UL), expecting(false), expected(0UL){}
+
+
+// class BusManager
+// constructors
+BusManager::BusManager()
+  : devices_(0), n_(0), busy_(false), dropped_(0UL){}
+// functions
+// Register a device, returning its id for post(), or -1 if there are BUS_DEVICES
+int BusManager::add(const char* name, const uint8_t addr, const uint8_t priority)
+{
+  if ( devices_>=BUS_DEVICES ) return(-1);
+  BusDevice *d  = &dev_[devices_];
+  d->name       = name;
+  d->addr       = addr;
+  d->priority   = priority;
+  return(devices_++);
+}
+
+// Queue job(arg) on device dev.   False if the queue is full and it is lost.
+bool BusManager::post(const int dev, BusJob job, void* arg)
+{
+  if ( dev<0 || dev>=devices_ ) return(false);
+  dev_[dev].expecting = false;
+  for (int i=0; i<n_; i++)
+  {
+    if ( queue_[i].dev==dev && queue_[i].job==job && queue_[i].arg==arg )
+    {
+      dev_[dev].coalesced++;
+      return(true);
+    }
+  }
+  if ( n_>=BUS_QUEUE )
+  {
+    dropped_++;
+    return(false);
+  }
+  Entry *e  = &queue_[n_++];
+  e->dev    = dev;
+  e->job    = job;
+  e->arg    = arg;
+  e->posted = micros();
+  return(true);
+}
+
+// Device dev will post a job at when, ms;  less urgent jobs aren't started near then.
+// Cleared by its next post().
+void BusManager::expect(const int dev, const unsigned long when)
+{
+  if ( dev<0 || dev>=devices_ ) return;
+  dev_[dev].expecting = true;
+  dev_[dev].expected  = when;
+}
+
+// Run the jobs that may go this pass.   Returns the number run.
+int BusManager::run(const unsigned long now)
+{
+  int top   = 0;      // Most urgent priority registered
+  int guard = -1;     // Most urgent priority expected within BUS_GUARD_MS
+  for (int d=0; d<devices_; d++)
+  {
+    top = max(top, int(dev_[d].priority));
+    long until = (long)(dev_[d].expected-now);   // Signed so millis() rollover is harmless
+    if ( dev_[d].expecting && until<=long(BUS_GUARD_MS) && until>=-long(BUS_GUARD_MS) )
+      guard = max(guard, int(dev_[d].priority));
+  }
+  int   ran         = 0;
+  bool  background  = false;  // Ran the one less urgent job of the pass
+  int   i;
+  while ( (i = next_())>=0 )
+  {
+    int priority = dev_[queue_[i].dev].priority;
+    if ( priority<top )
+    {
+      if ( background ) break;
+      if ( priority<guard )
+      {
+        dev_[queue_[i].dev].held++;
+        break;
+      }
+      background = true;
+    }
+    run_(i);
+    ran++;
+  }
+  return(ran);
+}
+
+// Most urgent waiting job, first posted of a priority, or -1 if none
+int BusManager::next_(void)
+{
+  int best = -1;
+  for (int i=0; i<n_; i++)
+    if ( best<0 || dev_[queue_[i].dev].priority>dev_[queue_[best].dev].priority ) best = i;
+  return(best);
+}
+
+// Take job i off the queue, run it and record it
+void BusManager::run_(const int i)
+{
+  Entry e = queue_[i];
+  for (int j=i; j<n_-1; j++) queue_[j] = queue_[j+1];
+  n_--;
+  busy_ = true;
+  unsigned long start = micros();
+  bool          ok    = e.job(e.arg);
+  unsigned long end   = micros();
+  busy_ = false;
+  BusDevice *d  = &dev_[e.dev];
+  unsigned long wait = start-e.posted;
+  unsigned long busy = end-start;
+  d->jobs++;
+  if ( !ok ) d->errors++;
+  d->waitSum   += wait;
+  d->waitMax    = max(d->waitMax, wait);
+  d->busySum   += busy;
+  d->busyMax    = max(d->busyMax, busy);
+}
+
+void BusManager::print(void)
+{
+  Serial.printf("bus: pending=%d dropped=%lu\n", n_, dropped_);
+  for (int i=0; i<devices_; i++)
+  {
+    BusDevice *d = &dev_[i];
+    double    n  = d->jobs>0 ? double(d->jobs) : 1.0;
+    Serial.printf("bus: %-8s 0x%02x jobs=%lu errors=%lu coalesced=%lu held=%lu wait=%.0f/%lu busy=%.0f/%lu us\n",
+      d->name, d->addr, d->jobs, d->errors, d->coalesced, d->held, d->waitSum/n, d->waitMax,
+      d->busySum/n, d->busyMax);
+  }
+}
@@ -0,0 +1,88 @@
+/***************************************************
+  Prioritized transactions on the shared I2C bus
+
+  The sensor and the LED matrices share one Wire bus at 100 kHz.   Rather
+  than each driver taking the bus whenever it likes, they post jobs here
+  and loop() calls run() once a pass.   A job is a short run of blocking
+  transactions on one device, returning false if the bus failed.   Jobs
+  of the most urgent device priority posted all run;  of the rest only
+  one runs a pass, so a display flush holds the loop for one job at
+  most.   A device that will need the bus soon, like the sensor waiting
+  out its conversion, says so with expect(), and nothing less urgent is
+  started within BUS_GUARD_MS of that time.   The same job posted again
+  before it runs is one job, counted as coalesced.
+
+  For each device are kept the jobs run, the errors, and the wait from
+  post to start and the time on the bus, mean and worst, us.
+
+  Class code for embedded application.
+
+  20-Feb-2016   Dave Gutz   Created
+ ****************************************************/
+
+#ifndef _myBus_H
+#define _myBus_H
+
+#include "application.h"
+
+#define BUS_DEVICES     4                   // Most devices
+#define BUS_QUEUE       8                   // Most jobs waiting
+#define BUS_GUARD_MS    3UL                 // Longest job of a lower priority, ms.   18 byte frame at 100 kHz is 1.7.
+#define BUS_SENSOR      2                   // Priority of the control-critical sensor
+#define BUS_DISPLAY     1                   // Priority of the LED matrices
+
+typedef bool (*BusJob)(void* arg);         // Transactions of one job, false if the bus failed
+
+
+class BusDevice
+{
+public:
+  BusDevice();
+  const char*   name;       // Label for reports
+  uint8_t       addr;       // Bus address
+  uint8_t       priority;   // Larger runs first
+  unsigned long jobs;       // Run
+  unsigned long errors;     // Run and failed
+  unsigned long coalesced;  // Posts merged into a job already waiting
+  unsigned long held;       // Passes a due job was held for a more urgent expected one
+  double        waitSum;    // Post to start, us
+  unsigned long waitMax;
+  double        busySum;    // On the bus, us
+  unsigned long busyMax;
+  bool          expecting;  // expect() is set
+  unsigned long expected;   // Time of the expected job, ms
+};
+
+
+class BusManager
+{
+public:
+  BusManager();
+  int           add(const char* name, const uint8_t addr, const uint8_t priority);
+  bool          post(const int dev, BusJob job, void* arg);
+  void          expect(const int dev, const unsigned long when);
+  int           run(const unsigned long now);
+  int           pending(void){return(n_);};
+  bool          busy(void){return(busy_);};     // In a job, safe to read from an interrupt
+  const BusDevice& device(const int dev){return(dev_[dev]);};
+  void          print(void);
+protected:
+  struct Entry
+  {
+    int           dev;
+    BusJob        job;
+    void*         arg;
+    unsigned long posted;   // us
+  };
+  int           next_(void);
+  void          run_(const int i);
+  BusDevice     dev_[BUS_DEVICES];
+  int           devices_;   // Registered devices
+  Entry         queue_[BUS_QUEUE];  // In order posted
+  int           n_;         // Jobs waiting
+  volatile bool busy_;      // A job has the bus
+  unsigned long dropped_;   // Posts lost to a full queue
+};
+
+
+#endif
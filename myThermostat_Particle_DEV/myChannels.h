@@ -0,0 +1,56 @@
+/***************************************************
+  The thermostat's published channels
+
+  Deadband, longest time between sends, the group of the four staggered
+  PUBLISH_DELAY*4 groups that sent it before (kept for the bytes/hr
+  comparison) and the format of each Blynk virtual pin, for setup() and
+  for host/hostThermostat.   decimals is 0 for an int, 3 for a double and
+  PUB_TEXT for the hh:mm string of V15.   Pins are the numbers of V0..V20.
+
+  20-Feb-2016   Dave Gutz   Created
+ ****************************************************/
+
+#ifndef _myChannels_H
+#define _myChannels_H
+
+#include "myPublish.h"
+
+#define PUB_STAT_AGE     300000UL           // Longest time between stat publishes, inside the replay gap, ms
+#define PUB_FAST_AGE     300000UL           // Longest time between Blynk writes of temperatures and CALL, ms
+#define PUB_SLOW_AGE     1800000UL          // Longest time between Blynk writes of settings, and Uptime, ms
+#define PUB_PINS         21                 // Blynk virtual pins, V0..V20
+
+struct BlynkChannel
+{
+  int           pin;        // Virtual pin
+  double        deadband;   // Change that is sent
+  unsigned long maxAge;     // Longest time between sends, ms
+  int           group;      // Fixed group it was written in
+  int           decimals;   // Format, 0, 3 or PUB_TEXT
+};
+
+static const BlynkChannel blynkChannels[] = {
+  {0,   0.5,    PUB_FAST_AGE, 0, 0},        // CALL
+  {2,   0.1,    PUB_FAST_AGE, 0, 3},        // Ta_Sense
+  {3,   0.5,    PUB_SLOW_AGE, 0, 0},        // hum
+  {4,   0.1,    PUB_FAST_AGE, 0, 3},        // tempComp
+  {5,   0.5,    PUB_SLOW_AGE, 0, 0},        // held
+  {7,   0.1,    PUB_FAST_AGE, 1, 3},        // controlTime, hr
+  {8,   0.1,    PUB_SLOW_AGE, 1, 3},        // updateTime
+  {9,   0.5,    PUB_SLOW_AGE, 1, 0},        // potDmd
+  {10,  0.5,    PUB_SLOW_AGE, 1, 0},        // lastWebDmd
+  {11,  0.5,    PUB_SLOW_AGE, 1, 0},        // set
+  {12,  0.5,    PUB_SLOW_AGE, 2, 0},        // schdDmd
+  {13,  0.1,    PUB_FAST_AGE, 2, 3},        // Ta_Sense
+  {14,  0.5,    PUB_SLOW_AGE, 2, 0},        // I2C_Status
+  {15,  4.5,    PUB_FAST_AGE, 2, PUB_TEXT}, // hmString, offered as minutes
+  {16,  0.1,    PUB_FAST_AGE, 2, 3},        // callCount+set-HYST
+  {17,  0.5,    PUB_SLOW_AGE, 3, 0},        // reco
+  {18,  0.5,    PUB_SLOW_AGE, 3, 3},        // OAT
+  {19,  0.1,    PUB_FAST_AGE, 3, 3},        // Ta_Obs
+  {20,  0.01,   PUB_FAST_AGE, 3, 3}         // rejectHeat*200
+};
+#define BLYNK_CHANNELS  int(sizeof(blynkChannels)/sizeof(blynkChannels[0]))
+
+
+#endif
@@ -0,0 +1,231 @@
+/***************************************************
+  A simple dynamic filter library, templated
+
+  Header-only versions of the rate-lag filters in myFilters.h, without
+  virtual calls or heap.   S is the sample type (float or double).
+  Step is FIXED_STEP, where the lag state integrates with the design T,
+  or VARIABLE_STEP, where calculate() takes the measured update time.
+
+  Coefficients are literal types with constexpr constructors, so when T
+  and tau are constants they are computed by the compiler:
+      constexpr RateLagExpCoeff<double> k(5.0, 40.0);
+      RateLagExpT<double, VARIABLE_STEP> filter(k, -0.1, 0.1);
+
+  A VARIABLE_STEP filter discretizes each update for the T it is given,
+  quantized to 1 ms.   The design T uses the constructor coefficients;
+  any other T costs one exp() the first time it is seen and is then kept
+  in a FILTER_CACHE entry table indexed by ms, so the jitter a late loop
+  pass puts on T is handled exactly without an exp() per sample.
+
+  The classes in myFilters.h are thin wrappers around these.
+
+  Class code for embedded application.
+
+  10-Feb-2016   Dave Gutz   Created
+ ****************************************************/
+
+#ifndef _myFilterTemplates_H
+#define _myFilterTemplates_H
+
+#include "math.h"
+
+#ifndef FILTER_CACHE
+  #define FILTER_CACHE  32                  // Variable step coefficient cache entries, ms of lateness covered
+#endif
+
+enum FilterStep {FIXED_STEP, VARIABLE_STEP};
+
+
+// exp(x) usable in constant expressions.   Halve x until it is small, sum the
+// series, then square back up, each half evaluated once so the work is
+// linear in the halvings.   Agrees with the library exp to rounding for
+// the -T/tau range filters use.
+constexpr double filterExpSeries(const double x, const int n, const double term, const double sum)
+{
+  return(n>20 ? sum : filterExpSeries(x, n+1, term*x/n, sum+term*x/n));
+}
+constexpr double filterSq(const double y)
+{
+  return(y*y);
+}
+constexpr double filterExp(const double x)
+{
+  return((x<-0.5 || x>0.5) ? filterSq(filterExp(x/2.0)) : filterExpSeries(x, 1, 1.0, 1.0));
+}
+
+
+// Exponential rate-lag coefficients for update time T and time constant tau
+template <typename S>
+struct RateLagExpCoeff
+{
+  constexpr RateLagExpCoeff(const S T, const S tau)
+    : RateLagExpCoeff(T, tau, filterExp(-T/tau)){}
+  constexpr RateLagExpCoeff(const S T, const S tau, const double eTt)   // eTt = exp(-T/tau)
+    : T(T), tau(tau), a(tau/T - eTt/(1.0-eTt)), b(1.0/(1.0-eTt) - tau/T), c((1.0-eTt)/T){}
+  S T;
+  S tau;
+  S a;
+  S b;
+  S c;
+};
+
+// Tustin rate-lag coefficients, non-pre-warped
+template <typename S>
+struct RateLagTustinCoeff
+{
+  constexpr RateLagTustinCoeff(const S T, const S tau)
+    : T(T), tau(tau), a(2.0/(2.0*tau + T)), b((2.0*tau - T)/(2.0*tau + T)){}
+  S T;
+  S tau;
+  S a;
+  S b;
+};
+
+
+// Per-step coefficient storage.   Nothing for a fixed step.
+template <typename S, FilterStep Step>
+struct RateLagExpSteps
+{
+  constexpr RateLagExpSteps(void){}
+  void  clear(void){}
+};
+
+// Variable step:  coefficients by update time in ms, direct-mapped.   Late
+// passes land on consecutive ms past the design T, so they don't collide.
+template <typename S>
+struct RateLagExpSteps<S, VARIABLE_STEP>
+{
+  struct Entry
+  {
+    constexpr Entry(void) : ms(0), a(0), b(0), c(0){}
+    unsigned long ms;         // Update time, ms, 0 if empty
+    S     a;
+    S     b;
+    S     c;
+  };
+  constexpr RateLagExpSteps(void) : cache(), hits(0), misses(0){}
+  const Entry& lookup(const unsigned long ms, const S tau)
+  {
+    Entry& e = cache[ms % FILTER_CACHE];
+    if ( e.ms==ms )
+    {
+      hits++;
+      return(e);
+    }
+    misses++;
+    RateLagExpCoeff<S> k(S(ms)/1000.0, tau, exp(-double(ms)/1000.0/double(tau)));
+    e.ms  = ms;
+    e.a   = k.a;
+    e.b   = k.b;
+    e.c   = k.c;
+    return(e);
+  }
+  void  clear(void)
+  {
+    for (int i=0; i<FILTER_CACHE; i++) cache[i].ms = 0;
+  }
+  Entry         cache[FILTER_CACHE];
+  unsigned long hits;         // Off-design T found in cache
+  unsigned long misses;       // Off-design T computed
+};
+
+
+// Exponential rate-lag rate calculator
+template <typename S, FilterStep Step=FIXED_STEP>
+class RateLagExpT
+{
+public:
+  constexpr RateLagExpT(const RateLagExpCoeff<S> k, const S min, const S max)
+    : k_(k), nominalMs_((unsigned long)(k.T*1000.0 + 0.5)), min_(min), max_(max), rate_(0),
+    lstate_(0), rstate_(0), steps_(){}
+  RateLagExpT(const S T, const S tau, const S min, const S max)
+    : k_(T, tau), nominalMs_((unsigned long)(T*1000.0 + 0.5)), min_(min), max_(max), rate_(0),
+    lstate_(0), rstate_(0), steps_(){}
+  S calculate(const S in, const int RESET)
+  {
+    if ( RESET>0 ) reset(in);
+    rateState(in, k_.a, k_.b, k_.c, k_.T);
+    return(rate_);
+  }
+  S calculate(const S in, const int RESET, const S T)
+  {
+    static_assert(Step==VARIABLE_STEP, "update time is fixed; use calculate(in, RESET)");
+    if ( RESET>0 ) reset(in);
+    unsigned long ms = (unsigned long)(T*1000.0 + 0.5);
+    if ( ms==nominalMs_ || T<=0 ) rateState(in, k_.a, k_.b, k_.c, k_.T);
+    else
+    {
+      const typename RateLagExpSteps<S, Step>::Entry& e = steps_.lookup(ms, k_.tau);
+      rateState(in, e.a, e.b, e.c, S(ms)/1000.0);
+    }
+    return(rate_);
+  }
+  void  assignCoeff(const S T, const S tau)
+  {
+    k_          = RateLagExpCoeff<S>(T, tau, exp(-double(T)/double(tau)));
+    nominalMs_  = (unsigned long)(T*1000.0 + 0.5);
+    steps_.clear();
+  };
+  void  reset(const S in){lstate_ = in; rstate_ = in;};
+  S     rate(void) const {return(rate_);};
+  S     state(void) const {return(lstate_);};
+  S     a(void) const {return(k_.a);};
+  S     b(void) const {return(k_.b);};
+  S     c(void) const {return(k_.c);};
+  S     T(void) const {return(k_.T);};
+  S     tau(void) const {return(k_.tau);};
+  S     lstate(void) const {return(lstate_);};
+  S     rstate(void) const {return(rstate_);};
+  unsigned long cacheHits(void) const {return(steps_.hits);};
+  unsigned long cacheMisses(void) const {return(steps_.misses);};
+protected:
+  void  rateState(const S in, const S a, const S b, const S c, const S T)
+  {
+    S r     = c*(a*rstate_ + b*in - lstate_);
+    r       = r<max_ ? r : max_;
+    rate_   = r>min_ ? r : min_;
+    rstate_ = in;
+    lstate_ += T*rate_;
+  }
+  RateLagExpCoeff<S> k_;
+  unsigned long nominalMs_;   // Design update time, ms
+  S     min_;
+  S     max_;
+  S     rate_;
+  S     lstate_;   // lag state
+  S     rstate_;   // rate state
+  RateLagExpSteps<S, Step> steps_;
+};
+
+
+// Tustin rate-lag rate calculator, non-pre-warped, fixed update rate
+template <typename S>
+class RateLagTustinT
+{
+public:
+  constexpr RateLagTustinT(const RateLagTustinCoeff<S> k, const S min, const S max)
+    : k_(k), min_(min), max_(max), rate_(0), state_(0){}
+  RateLagTustinT(const S T, const S tau, const S min, const S max)
+    : k_(T, tau), min_(min), max_(max), rate_(0), state_(0){}
+  S calculate(const S in, const int RESET)
+  {
+    if ( RESET>0 ) state_ = in;
+    S r     = k_.a*(in - state_);
+    r       = r<max_ ? r : max_;
+    rate_   = r>min_ ? r : min_;
+    state_  = in*(1.0-k_.b) + state_*k_.b;
+    return(rate_);
+  }
+  void  assignCoeff(const S T, const S tau){k_ = RateLagTustinCoeff<S>(T, tau);};
+  S     rate(void) const {return(rate_);};
+  S     state(void) const {return(state_);};
+protected:
+  RateLagTustinCoeff<S> k_;
+  S     min_;
+  S     max_;
+  S     rate_;
+  S     state_;
+};
+
+
+#endif
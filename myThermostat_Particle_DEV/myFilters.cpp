@@ -35,12 +35,9 @@ double DiscreteFilter::state(void){return(0);}
 
 // Tustin rate-lag rate calculator, non-pre-warped, no limits, fixed update rate
 // constructors
-RateLagTustin::RateLagTustin() : DiscreteFilter(){}
+RateLagTustin::RateLagTustin() : DiscreteFilter(), f_(1.0, 0.0, -1e32, 1e32){}
 RateLagTustin::RateLagTustin(const double T, const double tau, const double min, const double max)
-: DiscreteFilter(T, tau, min, max)
-{
-  RateLagTustin::assignCoeff(tau);
-}
+: DiscreteFilter(T, tau, min, max), f_(T, tau, min, max){}
 //RateLagTustin::RateLagTustin(const RateLagTustin & RLT)
 //: DiscreteFilter(RLT.T_, RLT.tau_, RLT.min_, RLT.max_){}
 RateLagTustin::~RateLagTustin(){}
@@ -48,37 +45,29 @@ RateLagTustin::~RateLagTustin(){}
 // functions
 double RateLagTustin::calculate(double in, int RESET)
 {
-  if (RESET>0)
-  {
-    state_ = in;
-  }
-  RateLagTustin::rateState(in);
+  rate_ = f_.calculate(in, RESET);
   return(rate_);
 }
 void RateLagTustin::rateState(double in)
 {
-  rate_   =  max(min(a_*(in - state_), max_), min_);
-  state_  = in*(1.0-b_) + state_*b_;
+  rate_ = f_.calculate(in, 0);
 }
 void RateLagTustin::assignCoeff(double tau)
 {
-  a_  = 2.0 / (2.0*tau_ + T_);
-  b_  = (2.0*tau_ - T_)/(2.0*tau_ + T_);
+  f_.assignCoeff(T_, tau_);
 }
-double RateLagTustin::state(void){return(state_);};
+double RateLagTustin::state(void){return(f_.state());};
 
 
 
 
 
 
-// Tustin rate-lag rate calculator, non-pre-warped, no limits, fixed update rate
+// Exponential rate-lag rate calculator
 // constructors
-RateLagExp::RateLagExp() : DiscreteFilter(){}
+RateLagExp::RateLagExp() : DiscreteFilter(), f_(1.0, 1.0, -1e32, 1e32){}
 RateLagExp::RateLagExp(const double T, const double tau, const double min, const double max)
-: DiscreteFilter(T, tau, min, max){
-  RateLagExp::assignCoeff(tau);
-}
+: DiscreteFilter(T, tau, min, max), f_(T, tau, min, max){}
 //RateLagExp::RateLagExp(const RateLagExp & RLT)
 //: DiscreteFilter(RLT.T_, RLT.tau_, RLT.min_, RLT.max_){}
 RateLagExp::~RateLagExp(){}
@@ -86,41 +75,24 @@ RateLagExp::~RateLagExp(){}
 // functions
 double RateLagExp::calculate(double in, int RESET)
 {
-  if (RESET>0)
-  {
-    lstate_ = in;
-    rstate_ = in;
-  }
-  RateLagExp::rateState(in);
+  rate_ = f_.calculate(in, RESET);
   return(rate_);
 }
 double RateLagExp::calculate(double in, int RESET, const double T)
 {
-  if (RESET>0)
-  {
-    lstate_ = in;
-    rstate_ = in;
-  }
-  RateLagExp::rateState(in, T);
+  rate_ = f_.calculate(in, RESET, T);
   return(rate_);
 }
 void RateLagExp::rateState(double in)
 {
-  rate_    =  max(min(c_*(a_*rstate_ + b_*in - lstate_), max_), min_);
-  rstate_  =  in;
-  lstate_  += T_*rate_;
+  rate_ = f_.calculate(in, 0);
 }
 void RateLagExp::rateState(double in, const double T)
 {
-  rate_    =  max(min(c_*(a_*rstate_ + b_*in - lstate_), max_), min_);
-  rstate_  =  in;
-  lstate_  += T*rate_;
+  rate_ = f_.calculate(in, 0, T);
 }
 void RateLagExp::assignCoeff(double tau)
 {
-  double eTt = exp(-T_/tau_);
-  a_   = tau_/T_ - eTt/(1-eTt);
-  b_   = 1.0/(1-eTt) - tau_/T_;
-  c_   = (1.0-eTt)/T_;
+  f_.assignCoeff(T_, tau_);
 }
-double RateLagExp::state(void){return(lstate_);};
+double RateLagExp::state(void){return(f_.state());};
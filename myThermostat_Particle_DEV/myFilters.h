@@ -1,14 +1,19 @@
 /***************************************************
   A simple dynamic filter library
 
-  Class code for embedded application.
+  Class code for embedded application.   The filter math lives in the
+  templates of myFilterTemplates.h; these classes keep the virtual
+  interface for existing callers.
 
   07-Jan-2015   Dave Gutz   Created
+  10-Feb-2016   Dave Gutz   Wrappers around myFilterTemplates.h
  ****************************************************/
 
 #ifndef _myFilters_H
 #define _myFilters_H
 
+#include "myFilterTemplates.h"
+
 
 class DiscreteFilter
 {
@@ -45,9 +50,7 @@ public:
   virtual void    rateState(double in);
   virtual double  state(void);
 protected:
-  double a_;
-  double b_;
-  double state_;
+  RateLagTustinT<double> f_;
 };
 
 
@@ -67,17 +70,13 @@ public:
   virtual void    rateState(double in);
   virtual void    rateState(double in, const double T);
   virtual double  state(void);
-  double a(){return(a_);};
-  double b(){return(b_);};
-  double c(){return(c_);};
-  double lstate(){return(lstate_);};
-  double rstate(){return(rstate_);};
+  double a(){return(f_.a());};
+  double b(){return(f_.b());};
+  double c(){return(f_.c());};
+  double lstate(){return(f_.lstate());};
+  double rstate(){return(f_.rstate());};
 protected:
-  double a_;
-  double b_;
-  double c_;
-  double lstate_;   // lag state
-  double rstate_;   // rate state
+  RateLagExpT<double, VARIABLE_STEP> f_;
 };
 
 
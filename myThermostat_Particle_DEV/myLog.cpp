@@ -0,0 +1,87 @@
+// Offline status ring log, see myLog.h
+#include "myLog.h"
+#include "myPersist.h"
+#include "mySchedule.h"
+
+static uint8_t logCrc(const LogRecord &r)
+{
+  return(crc16((const uint8_t*)&r, sizeof(LogRecord)-1) & 0xFF);
+}
+
+
+// RingLog Class Functions
+// Constructors
+RingLog::RingLog(void)
+  : head_(-1), newest_(0), sent_(0), valid_(0), appended_(0UL), dropped_(0UL)
+{}
+// Find the newest record and the last delivered.   Call after flashShadow.begin().
+// Returns the number of records waiting.
+int RingLog::begin(void)
+{
+  LogRecord r;
+  flashShadow.get(LOG_SENT_ADDR, sent_);
+  head_   = -1;
+  valid_  = 0;
+  for (int slot=0; slot<LOG_SLOTS; slot++)
+  {
+    if ( !read_(slot, &r) ) continue;
+    valid_++;
+    if ( head_<0 || int16_t(r.seq-newest_)>0 )
+    {
+      head_   = slot;
+      newest_ = r.seq;
+    }
+  }
+  if ( head_<0 ) newest_ = sent_;       // Empty, carry on from the last delivered
+  return(pending());
+}
+bool RingLog::read_(const int slot, LogRecord *r)
+{
+  EEPROM.get(LOG_ADDR + slot*sizeof(LogRecord), *r);
+  return(r->crc==logCrc(*r));
+}
+// Store r as the newest record, over the oldest when full
+void RingLog::append(LogRecord r)
+{
+  int slot = (head_+1) % LOG_SLOTS;
+  if ( valid_==LOG_SLOTS && pending()==LOG_SLOTS ) dropped_++;
+  r.seq = newest_ + 1;
+  r.crc = logCrc(r);
+  EEPROM.put(LOG_ADDR + slot*sizeof(LogRecord), r);
+  head_   = slot;
+  newest_ = r.seq;
+  if ( valid_<LOG_SLOTS ) valid_++;
+  appended_++;
+}
+// Records not yet delivered
+int RingLog::pending(void)
+{
+  int p = uint16_t(newest_-sent_);
+  return(min(p, valid_));
+}
+// Oldest undelivered record, false if none.   Records found damaged are passed over.
+bool RingLog::next(LogRecord *r)
+{
+  while ( pending()>0 )
+  {
+    uint16_t seq  = newest_ - pending() + 1;
+    int      slot = (head_ - uint16_t(newest_-seq) + LOG_SLOTS) % LOG_SLOTS;
+    if ( read_(slot, r) && r->seq==seq ) return(true);
+    sent_ = seq;
+  }
+  return(false);
+}
+// The record from next() was delivered
+void RingLog::sent(void)
+{
+  if ( pending()==0 ) return;
+  sent_ = newest_ - pending() + 1;
+  flashShadow.put(LOG_SENT_ADDR, sent_);
+}
+// Status text of a record, as the stat publish plus sequence and time.   Returns length.
+int RingLog::format(const LogRecord &r, char *buf, const int n)
+{
+  return(snprintf(buf, n, "|%02d:%02d|CALL %d|SET %d|TEMP %7.3f|TEMPC %7.3f|HELD %d|OAT %d|TMOD %7.3f|RECO %d|SEQ %u|TIME %lu|",
+    Time.hour(r.time), Time.minute(r.time), (r.flags & LOG_CALL)!=0, r.set, r.temp/100.0, r.tempComp/100.0,
+    (r.flags & LOG_HELD)!=0, r.oat, r.tmod/100.0, (r.flags & LOG_RECO)!=0, r.seq, (unsigned long)r.time));
+}
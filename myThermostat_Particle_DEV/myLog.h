@@ -0,0 +1,78 @@
+/***************************************************
+  Ring log of status records kept in flash while the cloud is away
+
+  While Particle.connected() is false the publish branch appends a
+  LogRecord every LOG_PERIOD instead of losing it.   Records are 16 bytes
+  in LOG_SLOTS slots from LOG_ADDR to the end of the emulated EEPROM, each
+  with a sequence number and CRC.   Appends go round the slots in turn, so
+  every slot is written once a lap and no header or head pointer is
+  rewritten;  begin() finds the newest record by sequence number.   When
+  the log is full the oldest record is overwritten.
+
+  Once connected again, next() and sent() hand the undelivered records to
+  the caller oldest first, to be published no faster than LOG_DRAIN.   The
+  last delivered sequence number goes to the settings flash through
+  flashShadow, so its writes coalesce and delivery survives a reset.
+
+  LOG_SLOTS records at LOG_PERIOD hold 3.7 hours of outage.
+
+  Class code for embedded application.
+
+  18-Feb-2016   Dave Gutz   Created
+ ****************************************************/
+
+#ifndef _myLog_H
+#define _myLog_H
+
+#include "application.h"
+
+#define LOG_ADDR        256                 // Flash address of the first slot, above the schedule
+#define LOG_SLOTS       111                 // Slots, to the end of the 2047 byte EEPROM
+#define LOG_SENT_ADDR   6                   // Settings flash address of the last delivered sequence number
+#define LOG_PERIOD      120000UL            // Time between records while offline, ms
+#define LOG_DRAIN       2000UL              // Time between delivered records, ms, inside the cloud publish limit
+
+#define LOG_CALL        0x01                // LogRecord flags
+#define LOG_HELD        0x02
+#define LOG_RECO        0x04
+
+
+// One status record, scaled to integers
+struct LogRecord
+{
+  uint32_t  time;       // Time.now(), s
+  uint16_t  seq;        // Sequence number
+  int16_t   temp;       // Ta_Sense, F/100
+  int16_t   tempComp;   // tempComp, F/100
+  int16_t   tmod;       // Ta_Obs, F/100
+  uint8_t   set;        // Setpoint, F
+  int8_t    oat;        // OAT, F
+  uint8_t   flags;      // LOG_CALL, LOG_HELD, LOG_RECO
+  uint8_t   crc;        // Low byte of crc16 of the rest
+};
+
+
+class RingLog
+{
+public:
+  RingLog(void);
+  int           begin(void);
+  void          append(LogRecord r);
+  bool          next(LogRecord *r);
+  void          sent(void);
+  int           pending(void);
+  int           format(const LogRecord &r, char *buf, const int n);
+  unsigned long appended(void){return(appended_);};
+  unsigned long dropped(void){return(dropped_);};   // Overwritten before delivery
+private:
+  bool          read_(const int slot, LogRecord *r);
+  int           head_;        // Slot of the newest record, -1 if empty
+  uint16_t      newest_;      // Sequence number of the newest record
+  uint16_t      sent_;        // Sequence number of the last delivered record
+  int           valid_;       // Slots holding records
+  unsigned long appended_;
+  unsigned long dropped_;
+};
+
+
+#endif
@@ -0,0 +1,51 @@
+// Settings flash shadow, see myPersist.h
+#include "myPersist.h"
+
+// FlashShadow Class Functions
+// Constructors
+FlashShadow::FlashShadow(void)
+  : dirty_(false), changed_(0UL), puts_(0UL), commits_(0UL)
+{
+  memset(shadow_, 0, PERSIST_SIZE);
+  memset(flash_,  0, PERSIST_SIZE);
+}
+// Read the shadowed flash, once in setup()
+void FlashShadow::begin(void)
+{
+  EEPROM.get(0, flash_);
+  memcpy(shadow_, flash_, PERSIST_SIZE);
+  dirty_ = false;
+}
+void FlashShadow::read(const int addr, uint8_t *p, const int n)
+{
+  if ( addr<0 || addr+n>PERSIST_SIZE ) return;
+  memcpy(p, shadow_+addr, n);
+}
+// Change the RAM copy.   The quiet time restarts only if something changed.
+void FlashShadow::write(const int addr, const uint8_t *p, const int n)
+{
+  if ( addr<0 || addr+n>PERSIST_SIZE ) return;
+  puts_++;
+  if ( memcmp(shadow_+addr, p, n)==0 ) return;
+  memcpy(shadow_+addr, p, n);
+  dirty_    = memcmp(shadow_, flash_, PERSIST_SIZE)!=0;
+  changed_  = millis();
+}
+// Commit once quiet.   True if flash was written.   now may be from before the
+// last change, earlier in the pass, so compared signed.
+bool FlashShadow::poll(const unsigned long now)
+{
+  if ( !dirty_ || (long)(now-changed_)<(long)PERSIST_QUIET ) return(false);
+  flush();
+  return(true);
+}
+void FlashShadow::flush(void)
+{
+  if ( !dirty_ ) return;
+  for (int i=0; i<PERSIST_SIZE; i++)
+    if ( shadow_[i]!=flash_[i] ) EEPROM.write(i, shadow_[i]);
+  memcpy(flash_, shadow_, PERSIST_SIZE);
+  dirty_ = false;
+  commits_++;
+}
+FlashShadow flashShadow;
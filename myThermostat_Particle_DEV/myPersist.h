@@ -0,0 +1,65 @@
+/***************************************************
+  Write-coalescing RAM shadow of the settings flash
+
+  The first PERSIST_SIZE bytes of the emulated EEPROM, where
+  saveTemperature() keeps the setpoint, hold and web demand, are read once
+  by begin() and afterwards served from RAM.   put() only changes the RAM
+  copy and marks it dirty;  poll() in loop() commits it once nothing has
+  changed for PERSIST_QUIET, writing just the bytes that differ from flash.
+  A burst of pot or Blynk slider changes so costs one flash write.   flush()
+  commits at once, for a controlled reset or firmware update.   A power
+  loss inside the quiet time loses the last change, as one during an
+  EEPROM.put always could.
+
+  puts() counts put() calls, each an EEPROM.put before this;  commits()
+  counts flash commits;  avoided() is the difference.
+
+  Class code for embedded application.
+
+  17-Feb-2016   Dave Gutz   Created
+ ****************************************************/
+
+#ifndef _myPersist_H
+#define _myPersist_H
+
+#include "application.h"
+
+#define PERSIST_SIZE    16                  // Flash bytes shadowed from address 0, below SCHD_ADDR
+#define PERSIST_QUIET   10000UL             // Time without change before a commit, ms
+
+
+class FlashShadow
+{
+public:
+  FlashShadow(void);
+  void          begin(void);
+  template <typename T> T& get(const int addr, T& t)
+  {
+    read(addr, (uint8_t*)&t, sizeof(T));
+    return(t);
+  };
+  template <typename T> const T& put(const int addr, const T& t)
+  {
+    write(addr, (const uint8_t*)&t, sizeof(T));
+    return(t);
+  };
+  void          read(const int addr, uint8_t *p, const int n);
+  void          write(const int addr, const uint8_t *p, const int n);
+  bool          poll(const unsigned long now);
+  void          flush(void);
+  bool          dirty(void){return(dirty_);};
+  unsigned long puts(void){return(puts_);};
+  unsigned long commits(void){return(commits_);};
+  unsigned long avoided(void){return(puts_-commits_);};
+private:
+  uint8_t       shadow_[PERSIST_SIZE];  // Latest settings
+  uint8_t       flash_[PERSIST_SIZE];   // As in flash
+  bool          dirty_;                 // shadow_ differs from flash_
+  unsigned long changed_;               // Time of the last change, ms
+  unsigned long puts_;                  // Calls to put() and write()
+  unsigned long commits_;               // Writes to flash
+};
+extern  FlashShadow flashShadow;        // Settings flash, begun in setup()
+
+
+#endif
@@ -0,0 +1,120 @@
+/***************************************************
+  A per-stage loop() profiler
+
+  Class code for embedded application.
+
+  06-Feb-2016   Dave Gutz   Created
+ ****************************************************/
+#include "myProfiler.h"
+#include "application.h"
+
+#ifdef PLATFORM_ID
+  // Cortex-M3 debug registers
+  #define PROF_DEMCR        (*(volatile uint32_t *)0xE000EDFC)
+  #define PROF_DWT_CTRL     (*(volatile uint32_t *)0xE0001000)
+  #define PROF_DWT_CYCCNT   (*(volatile uint32_t *)0xE0001004)
+  #if defined(STM32F2XX)
+    #define PROF_TICKS_US   120UL             // Photon core clock, MHz
+  #else
+    #define PROF_TICKS_US   72UL              // Core core clock, MHz
+  #endif
+  #define PROF_WRAP_US      (0xFFFFFFFFUL/PROF_TICKS_US)  // Cycle counter wrap, us
+#else
+  #define PROF_TICKS_US     1UL               // micros()
+#endif
+
+static const char* profNames[PROF_STAGES] = {"loop", "blynk", "read", "model", "filter",
+  "query", "disp", "ctrl", "pub"};
+
+// class LoopProfiler
+// constructors
+LoopProfiler::LoopProfiler()
+{
+  reset();
+}
+// functions
+// Start the cycle counter
+void LoopProfiler::begin(void)
+{
+#ifdef PLATFORM_ID
+  PROF_DEMCR     |= 0x01000000;   // TRCENA
+  PROF_DWT_CYCCNT = 0;
+  PROF_DWT_CTRL  |= 0x00000001;   // CYCCNTENA
+#endif
+}
+
+uint32_t LoopProfiler::ticks(void)
+{
+#ifdef PLATFORM_ID
+  return(PROF_DWT_CYCCNT);
+#else
+  return(micros());
+#endif
+}
+
+void LoopProfiler::enter(const ProfStage stage)
+{
+  start_[stage]   = ticks();
+#ifdef PLATFORM_ID
+  startUs_[stage] = micros();
+#endif
+}
+
+// Close a stage.   The unsigned tick difference is right for any span under
+// one counter wrap;  on the device a stage longer than half a wrap is timed
+// by micros() instead.
+void LoopProfiler::exit(const ProfStage stage)
+{
+  unsigned long us = (ticks() - start_[stage]) / PROF_TICKS_US;
+#ifdef PLATFORM_ID
+  unsigned long usMicros = micros() - startUs_[stage];
+  if ( usMicros>PROF_WRAP_US/2 ) us = usMicros;
+#endif
+  int k = 0;
+  while ( (us>>(k+1))>0 && k<PROF_BUCKETS-1 ) k++;
+  hist_[stage][k]++;
+  count_[stage]++;
+  total_[stage] += us;
+  if ( us>max_[stage] ) max_[stage] = us;
+}
+
+void LoopProfiler::reset(void)
+{
+  for (int i=0; i<PROF_STAGES; i++)
+  {
+    start_[i]   = 0;
+    startUs_[i] = 0;
+    count_[i]   = 0;
+    max_[i]     = 0;
+    total_[i]   = 0.0;
+    for (int k=0; k<PROF_BUCKETS; k++) hist_[i][k] = 0;
+  }
+}
+
+double LoopProfiler::meanUs(const ProfStage stage)
+{
+  if ( count_[stage]==0 ) return(0.0);
+  return(total_[stage]/double(count_[stage]));
+}
+
+// Compact text summary, see myProfiler.h.   Returns characters written.
+int LoopProfiler::summary(char* buf, const int size)
+{
+  int n = 0;
+  buf[0] = '\0';
+  for (int i=0; i<PROF_STAGES && n<size-1; i++)
+  {
+    char hist[PROF_BUCKETS+1];
+    for (int k=0; k<PROF_BUCKETS; k++)
+    {
+      if ( hist_[i][k]==0 ) hist[k] = '.';
+      else hist[k] = '0' + min(9UL, (hist_[i][k]*10UL + count_[i]-1)/count_[i]);
+    }
+    hist[PROF_BUCKETS] = '\0';
+    int w = snprintf(buf+n, size-n, "%s %lu/%lu %s\n", profNames[i],
+      (unsigned long)(meanUs(ProfStage(i))+0.5), max_[i], hist);
+    if ( w<0 ) break;
+    n += w;
+  }
+  return(min(n, size-1));
+}
@@ -0,0 +1,60 @@
+/***************************************************
+  A per-stage loop() profiler
+
+  Stage entry and exit are timestamped with the Cortex-M3 DWT cycle counter
+  on the device, or micros() when built without a Particle platform.   The
+  32-bit cycle counter wraps every 35.8 s at 120 MHz, so on the device
+  micros() is taken too and measures stages that run past half of that.   Each
+  stage keeps a fixed log2 histogram of durations in microseconds:  bucket
+  k counts durations in [2^k, 2^(k+1)) us, bucket 0 also holds < 1 us and
+  the last bucket everything longer, from 2^23 us, 8.4 s.   The longest
+  of each stage is kept too.
+
+  summary() writes one line per stage for a Particle.variable:
+      name mean/max us histogram
+  where histogram has one character per bucket, '.' for empty and '0'-'9'
+  for the bucket's share of that stage's samples in tenths (rounded up).
+
+  Class code for embedded application.
+
+  06-Feb-2016   Dave Gutz   Created
+ ****************************************************/
+
+#ifndef _myProfiler_H
+#define _myProfiler_H
+
+#include "application.h"
+
+#define PROF_BUCKETS  24                    // Histogram buckets, 1 us to 8.4 s and over.   Blynk, publish and
+                                            // connect stalls run to seconds.
+
+// Profiled stages of loop()
+enum ProfStage {PROF_LOOP, PROF_BLYNK, PROF_READ, PROF_MODEL, PROF_FILTER, PROF_QUERY,
+  PROF_DISPLAY, PROF_CONTROL, PROF_PUBLISH, PROF_STAGES};
+
+
+class LoopProfiler
+{
+public:
+  LoopProfiler();
+  void          begin(void);
+  void          enter(const ProfStage stage);
+  void          exit(const ProfStage stage);
+  void          reset(void);
+  unsigned long count(const ProfStage stage){return(count_[stage]);};
+  unsigned long maxUs(const ProfStage stage){return(max_[stage]);};
+  double        meanUs(const ProfStage stage);
+  unsigned long bucket(const ProfStage stage, const int k){return(hist_[stage][k]);};
+  int           summary(char* buf, const int size);
+  static uint32_t ticks(void);
+protected:
+  uint32_t      start_[PROF_STAGES];                  // Entry timestamp, ticks
+  unsigned long startUs_[PROF_STAGES];                // Entry timestamp, micros(), device only
+  unsigned long count_[PROF_STAGES];                  // Samples
+  unsigned long max_[PROF_STAGES];                    // Longest, us
+  double        total_[PROF_STAGES];                  // Sum, us
+  unsigned long hist_[PROF_STAGES][PROF_BUCKETS];     // log2 histogram
+};
+
+
+#endif
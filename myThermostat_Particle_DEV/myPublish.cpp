@@ -0,0 +1,83 @@
+// Change-driven publishing, see myPublish.h
+#include "myPublish.h"
+
+// PublishEngine Class Functions
+// Constructors
+PublishEngine::PublishEngine(void)
+  : n_(0), group_(PUB_GROUPS-1), burst_(0), now_(0UL), start_(0UL), bytes_(0), fixedBytes_(0),
+  messages_(0UL), fixedMessages_(0UL)
+{}
+// New channel, or -1 if there are PUB_CHANNELS
+int PublishEngine::add(const double deadband, const unsigned long maxAge, const int group)
+{
+  if ( n_>=PUB_CHANNELS ) return(-1);
+  Channel& c  = ch_[n_];
+  c.sent      = 0;
+  c.deadband  = deadband;
+  c.sentAt    = 0UL;
+  c.maxAge    = maxAge;
+  c.group     = group;
+  c.ever      = false;
+  return(n_++);
+}
+// Start of a publish pass
+void PublishEngine::poll(const unsigned long now)
+{
+  if ( messages_==0 && fixedMessages_==0 ) start_ = now;
+  now_    = now;
+  group_  = (group_+1) % PUB_GROUPS;
+  burst_  = 0;
+}
+// Offer the present value of a channel, a message of bytes.   True if it is to be sent.
+bool PublishEngine::offer(const int ch, const double v, const int bytes)
+{
+  if ( ch<0 || ch>=n_ ) return(false);
+  if ( !send_(ch, fabs(v-ch_[ch].sent)>ch_[ch].deadband, bytes) ) return(false);
+  ch_[ch].sent = v;
+  return(true);
+}
+// Offer a channel whose caller judged whether it moved
+bool PublishEngine::offerChanged(const int ch, const bool moved, const int bytes)
+{
+  if ( ch<0 || ch>=n_ ) return(false);
+  return(send_(ch, moved, bytes));
+}
+bool PublishEngine::send_(const int ch, const bool moved, const int bytes)
+{
+  Channel& c = ch_[ch];
+  if ( c.group==PUB_EVERY || c.group==group_ )
+  {
+    fixedBytes_ += bytes;
+    fixedMessages_++;
+  }
+  if ( c.ever && !moved && now_-c.sentAt<c.maxAge ) return(false);
+  if ( burst_>=PUB_BURST ) return(false);
+  c.sentAt  = now_;
+  c.ever    = true;
+  bytes_   += bytes;
+  messages_++;
+  burst_++;
+  return(true);
+}
+double PublishEngine::bytesPerHour(void)
+{
+  return(now_>start_ ? bytes_*3600000.0/(now_-start_) : 0.0);
+}
+double PublishEngine::fixedPerHour(void)
+{
+  return(now_>start_ ? fixedBytes_*3600000.0/(now_-start_) : 0.0);
+}
+
+
+// Bytes of Blynk.virtualWrite(pin, value):  header, "vw", pin and value, each terminated but the
+// last.   The value is an int if decimals is 0, hh:mm if PUB_TEXT and a double if not.
+int pubBlynkBytes(const int pin, const int decimals)
+{
+  int width = decimals==0 ? PUB_INT_WIDTH : (decimals==PUB_TEXT ? PUB_TEXT_WIDTH : PUB_REAL_WIDTH);
+  return(PUB_BLYNK_HEAD + 3 + (pin>=10 ? 2 : 1) + 1 + width);
+}
+// Bytes of Particle.publish(name, data)
+int pubCloudBytes(const char *name, const char *data)
+{
+  return(PUB_CLOUD_HEAD + strlen(name) + (data ? strlen(data) : 0));
+}
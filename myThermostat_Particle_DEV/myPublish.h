@@ -0,0 +1,83 @@
+/***************************************************
+  Change-driven publishing with deadbands
+
+  Each published quantity is a channel with a deadband and a maximum age.
+  Every publish pass loop() offers each channel its present value;  offer()
+  says to send it only if it has moved more than the deadband from what
+  was last sent, or what was sent is older than the maximum age, and
+  counts it as sent.   Quantities published together, like the fields of
+  the stat record, share one channel and the caller tells offerChanged()
+  whether any of them moved.   At most PUB_BURST messages go in one pass;
+  the rest stay due for the next, as the staggered groups spread them.
+
+  For the comparison the channels also keep the fixed cadence they
+  replaced:  a channel in group g was written every PUB_GROUPS-th pass,
+  one in PUB_EVERY each pass.   bytesPerHour() and fixedPerHour() are
+  the message bytes sent and those the fixed groups would have sent,
+  from the estimates of pubBlynkBytes() and pubCloudBytes().   A Blynk
+  value is estimated at a fixed width for its format, so offering it
+  formats nothing.
+
+  Class code for embedded application.
+
+  20-Feb-2016   Dave Gutz   Created
+ ****************************************************/
+
+#ifndef _myPublish_H
+#define _myPublish_H
+
+#include "application.h"
+
+#define PUB_CHANNELS    24                  // Most channels
+#define PUB_GROUPS      4                   // Fixed groups, written in turn, one a pass
+#define PUB_EVERY       -1                  // Group of a channel written every pass
+#define PUB_BURST       6                   // Most messages in a pass
+#define PUB_BLYNK_HEAD  5                   // Blynk message header, bytes
+#define PUB_CLOUD_HEAD  40                  // Particle event CoAP and DTLS framing, estimated, bytes
+#define PUB_TEXT        -1                  // Format of a Blynk hh:mm string, for pubBlynkBytes()
+#define PUB_INT_WIDTH   2                   // Characters of a Blynk int, typical
+#define PUB_REAL_WIDTH  6                   // Characters of a Blynk double, 68.125
+#define PUB_TEXT_WIDTH  5                   // Characters of hh:mm
+
+
+class PublishEngine
+{
+public:
+  PublishEngine(void);
+  int           add(const double deadband, const unsigned long maxAge, const int group);
+  void          poll(const unsigned long now);
+  bool          offer(const int ch, const double v, const int bytes);
+  bool          offerChanged(const int ch, const bool moved, const int bytes);
+  int           group(void){return(group_);};
+  unsigned long messages(void){return(messages_);};
+  unsigned long fixedMessages(void){return(fixedMessages_);};
+  double        bytesPerHour(void);
+  double        fixedPerHour(void);
+private:
+  bool          send_(const int ch, const bool moved, const int bytes);
+  struct Channel
+  {
+    double        sent;       // Value last sent
+    double        deadband;   // Change that is sent
+    unsigned long sentAt;     // Time sent, ms
+    unsigned long maxAge;     // Longest time between sends, ms
+    int           group;      // Fixed group, or PUB_EVERY
+    bool          ever;       // Sent at least once
+  };
+  Channel       ch_[PUB_CHANNELS];
+  int           n_;           // Channels
+  int           group_;       // Fixed group of this pass
+  int           burst_;       // Messages this pass
+  unsigned long now_;         // Time of this pass, ms
+  unsigned long start_;       // Time of the first pass, ms
+  double        bytes_;       // Sent
+  double        fixedBytes_;  // The fixed groups would have sent
+  unsigned long messages_;
+  unsigned long fixedMessages_;
+};
+
+int     pubBlynkBytes(const int pin, const int decimals);
+int     pubCloudBytes(const char *name, const char *data);
+
+
+#endif
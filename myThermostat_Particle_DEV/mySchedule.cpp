@@ -0,0 +1,183 @@
+// Weekly schedule in flash, see mySchedule.h
+#include "mySchedule.h"
+#include "mySubs.h"
+
+// CRC-16/CCITT, bitwise.   Continue a running crc by passing it back in.
+uint16_t crc16(const uint8_t *p, const int n, uint16_t crc)
+{
+  for (int i=0; i<n; i++)
+  {
+    crc ^= uint16_t(p[i])<<8;
+    for (int b=0; b<8; b++) crc = (crc & 0x8000) ? (crc<<1)^0x1021 : crc<<1;
+  }
+  return(crc);
+}
+
+
+// ScheduleStore Class Functions
+// Constructors
+ScheduleStore::ScheduleStore(const int addr)
+  : addr_(addr), pending_(false), forget_(false), stored_(false), length_(0), written_(0)
+{
+  active_.n   = 0;
+  defaults_.n = 0;
+  staged_.n   = 0;
+}
+// The compiled schedule, hourCh after the day offsets are added and checked
+void ScheduleStore::defaults(const float *hours, const float *temps, const int n)
+{
+  defaults_.n = 0;
+  for (int i=0; i<n && i<SCHD_RECORDS; i++)
+  {
+    defaults_.minute[i] = uint16_t(roundf(hours[i]*60.0));
+    defaults_.temp[i]   = uint8_t(roundf(temps[i]));
+    defaults_.n++;
+  }
+  if ( !stored_ ) activate_(defaults_);
+}
+// Read the stored schedule in one piece.   Returns true if it is valid and now
+// active, else the compiled schedule stays.
+bool ScheduleStore::load(void)
+{
+  EEPROM.get(addr_, image_);
+  if ( image_.magic!=SCHD_MAGIC || image_.version!=SCHD_VERSION ) return(false);
+  if ( image_.n<1 || image_.n>SCHD_RECORDS ) return(false);
+  uint16_t crc = crc16(&image_.version, 2);
+  if ( crc16(image_.rec, 3*image_.n, crc)!=image_.crc ) return(false);
+  List l;
+  l.n = 0;
+  for (int i=0; i<image_.n; i++)
+  {
+    uint16_t minute = image_.rec[3*i] | (uint16_t(image_.rec[3*i+1])<<8);
+    uint8_t  temp   = image_.rec[3*i+2];
+    if ( minute>7*24*60 || temp<MINSET || temp>MAXSET ) return(false);
+    if ( l.n>0 && minute<=l.minute[l.n-1] ) return(false);
+    l.minute[l.n] = minute;
+    l.temp[l.n++] = temp;
+  }
+  stored_ = true;
+  activate_(l);
+  return(true);
+}
+// Apply the commands of cmd, see mySchedule.h, to the latest schedule and stage
+// the result for poll().   Returns the number of changes, or -1 and nothing staged.
+int ScheduleStore::edit(const char *cmd)
+{
+  List  l      = pending_ ? staged_ : active_;
+  bool  forget = pending_ ? forget_ : !stored_;
+  const char *p = cmd;
+  while ( true )
+  {
+    while ( *p==' ' || *p==',' ) p++;
+    if ( *p=='\0' ) break;
+    if ( strncmp(p, "default", 7)==0 )
+    {
+      l       = defaults_;
+      forget  = true;
+      p      += 7;
+      continue;
+    }
+    int day, hr, mn, used = 0;
+    if ( sscanf(p, "%d %d:%d%n", &day, &hr, &mn, &used)!=3 ) return(-1);
+    if ( day<0 || day>6 || hr<0 || mn<0 || mn>59 || hr*60+mn>24*60 ) return(-1);
+    uint16_t minute = day*24*60 + hr*60 + mn;
+    p += used;
+    while ( *p==' ' ) p++;
+    if ( *p=='-' )
+    {
+      if ( !remove_(&l, minute) ) return(-1);
+      p++;
+    }
+    else
+    {
+      int temp;
+      if ( sscanf(p, "%d%n", &temp, &used)!=1 || temp<MINSET || temp>MAXSET ) return(-1);
+      if ( !insert_(&l, minute, temp) ) return(-1);
+      p += used;
+    }
+    forget = false;
+  }
+  if ( l.n<1 && !forget ) return(-1);
+  staged_   = l;
+  forget_   = forget;
+  pending_  = true;
+  return(l.n);
+}
+// Add or replace, keeping order
+bool ScheduleStore::insert_(List *l, const uint16_t minute, const uint8_t temp)
+{
+  int i = 0;
+  while ( i<l->n && l->minute[i]<minute ) i++;
+  if ( i<l->n && l->minute[i]==minute )
+  {
+    l->temp[i] = temp;
+    return(true);
+  }
+  if ( l->n>=SCHD_RECORDS ) return(false);
+  for (int j=l->n; j>i; j--)
+  {
+    l->minute[j] = l->minute[j-1];
+    l->temp[j]   = l->temp[j-1];
+  }
+  l->minute[i] = minute;
+  l->temp[i]   = temp;
+  l->n++;
+  return(true);
+}
+bool ScheduleStore::remove_(List *l, const uint16_t minute)
+{
+  int i = 0;
+  while ( i<l->n && l->minute[i]!=minute ) i++;
+  if ( i==l->n ) return(false);
+  for (int j=i; j<l->n-1; j++)
+  {
+    l->minute[j] = l->minute[j+1];
+    l->temp[j]   = l->temp[j+1];
+  }
+  l->n--;
+  return(true);
+}
+void ScheduleStore::activate_(const List &l)
+{
+  active_ = l;
+  for (int i=0; i<l.n; i++)
+  {
+    hours_[i] = float(l.minute[i])/60.0;
+    temps_[i] = float(l.temp[i]);
+  }
+}
+// Call every pass.   Makes a staged edit active, returning true when it does so
+// the caller can rebuild schedIndex, and writes SCHD_CHUNK bytes of it to flash.
+bool ScheduleStore::poll(void)
+{
+  bool changed = false;
+  if ( pending_ )
+  {
+    pending_  = false;
+    stored_   = !forget_;
+    activate_(staged_);
+    changed   = true;
+    // Compiled schedule:  header only, marked invalid so load() passes it over
+    image_.magic    = forget_ ? 0 : SCHD_MAGIC;
+    image_.version  = SCHD_VERSION;
+    image_.n        = forget_ ? 0 : active_.n;
+    for (int i=0; i<image_.n; i++)
+    {
+      image_.rec[3*i]   = active_.minute[i] & 0xFF;
+      image_.rec[3*i+1] = active_.minute[i]>>8;
+      image_.rec[3*i+2] = active_.temp[i];
+    }
+    image_.crc  = crc16(image_.rec, 3*image_.n, crc16(&image_.version, 2));
+    length_     = SCHD_HEADER + 3*image_.n;
+    written_    = 0;
+  }
+  // Records, then the header.   Only bytes that differ are written.
+  const uint8_t *b = (const uint8_t*)&image_;
+  int records = length_ - SCHD_HEADER;
+  for (int k=0; k<SCHD_CHUNK && written_<length_; k++, written_++)
+  {
+    int off = written_<records ? SCHD_HEADER+written_ : written_-records;
+    if ( EEPROM.read(addr_+off)!=b[off] ) EEPROM.write(addr_+off, b[off]);
+  }
+  return(changed);
+}
@@ -0,0 +1,89 @@
+/***************************************************
+  A weekly schedule kept in flash and editable at run time
+
+  The schedule is a list of up to SCHD_RECORDS changes, each the minute
+  of the week from midnight Sunday and the setpoint that holds after it,
+  in order.   In flash at SCHD_ADDR it is a SCHD_HEADER byte header:
+  magic, version, count and a CRC-16 of version, count and records;
+  then 3 byte records, minute low, minute high, setpoint.   load() reads
+  the whole image with one EEPROM.get() in setup().   Without a valid
+  image the compiled hourCh/tempCh given to defaults() are used.
+
+  edit() takes commands from Particle.function or Blynk, comma separated:
+      d hh:mm tt    Add or replace the change at day d (0=Sun) hh:mm, tt F
+      d hh:mm -     Remove the change at day d hh:mm
+      default       Back to the compiled schedule, forgetting the stored one
+  The commands of one call are checked as setup() checks hourCh, times of
+  day no later than 24:00 and kept in order, plus setpoints MINSET to
+  MAXSET, and apply all or none.   edit() only stages the result.   poll()
+  in loop() makes it active and writes it to flash SCHD_CHUNK bytes a pass,
+  records first and header last, so the loop never waits on the flash and
+  a write cut short fails the CRC at the next boot.
+
+  Class code for embedded application.
+
+  16-Feb-2016   Dave Gutz   Created
+ ****************************************************/
+
+#ifndef _mySchedule_H
+#define _mySchedule_H
+
+#include "application.h"
+
+#define SCHD_ADDR       16                  // Flash address of the stored schedule
+#define SCHD_RECORDS    64                  // Most schedule changes stored
+#define SCHD_HEADER     6                   // Flash header bytes
+#define SCHD_MAGIC      0x5348              // Flash header mark, "HS"
+#define SCHD_VERSION    1                   // Flash format version
+#define SCHD_CHUNK      16                  // Flash bytes written per poll()
+
+uint16_t  crc16(const uint8_t *p, const int n, uint16_t crc=0xFFFF);
+
+
+class ScheduleStore
+{
+public:
+  ScheduleStore(const int addr);
+  void          defaults(const float *hours, const float *temps, const int n);
+  bool          load(void);
+  int           edit(const char *cmd);
+  bool          poll(void);
+  const float*  hours(void){return(hours_);};     // Active change times, hr in week
+  const float*  temps(void){return(temps_);};     // Active setpoints, F
+  int           size(void){return(active_.n);};
+  bool          stored(void){return(stored_);};   // Active schedule is not the compiled one
+  bool          writing(void){return(written_<length_);};
+private:
+  struct List
+  {
+    uint16_t  minute[SCHD_RECORDS];   // Minute of week, 0 = midnight Sunday
+    uint8_t   temp[SCHD_RECORDS];     // Setpoint, F
+    int       n;                      // Changes
+  };
+  struct Image
+  {
+    uint16_t  magic;
+    uint8_t   version;
+    uint8_t   n;
+    uint16_t  crc;
+    uint8_t   rec[3*SCHD_RECORDS];
+  };
+  bool          insert_(List *l, const uint16_t minute, const uint8_t temp);
+  bool          remove_(List *l, const uint16_t minute);
+  void          activate_(const List &l);
+  int           addr_;        // Flash address
+  List          active_;      // In use
+  List          defaults_;    // Compiled
+  List          staged_;      // Edited, active at the next poll()
+  bool          pending_;     // staged_ waiting
+  bool          forget_;      // staged_ is the compiled schedule
+  bool          stored_;      // active_ is not the compiled schedule
+  float         hours_[SCHD_RECORDS];   // active_ for ScheduleIndex, hr in week
+  float         temps_[SCHD_RECORDS];   // active_ setpoints, F
+  Image         image_;       // Being written
+  int           length_;      // Bytes of image_ to write
+  int           written_;     // Bytes of image_ written
+};
+
+
+#endif
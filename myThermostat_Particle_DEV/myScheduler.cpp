@@ -0,0 +1,185 @@
+/***************************************************
+  A cooperative deadline scheduler for loop()
+
+  Class code for embedded application.
+
+  04-Feb-2016   Dave Gutz   Created
+ ****************************************************/
+#include "myScheduler.h"
+#include "application.h"
+
+// class Task
+// constructors
+Task::Task()
+  : name(""), period(0), priority(0), budget(0), group(SCHED_FREE), due(0), last(0),
+  runs(0), late(0), skipped(0), maxJitter(0), ready(false){}
+
+
+// class TaskScheduler
+// constructors
+TaskScheduler::TaskScheduler()
+  : n_(0), size_(0), passes_(0), idle_(0)
+{
+  for (int i=0; i<SCHED_MAX_TASKS; i++) prev_[i] = 0UL;
+}
+// functions
+// Register a task, returning its id or -1 if the table is full.  The first
+// run is due at 'first', ms.
+int TaskScheduler::add(const char* name, const unsigned long period, const uint8_t priority,
+  const unsigned long budget, const uint8_t group, const unsigned long first)
+{
+  if ( n_>=SCHED_MAX_TASKS || group>31 ) return(-1);
+  int id = n_++;
+  Task *t     = &tasks_[id];
+  t->name     = name;
+  t->period   = period;
+  t->priority = priority;
+  t->budget   = budget;
+  t->group    = group;
+  t->due      = first;
+  push(id);
+  return(id);
+}
+
+// Select this pass's work.  Only tasks whose deadline has passed are looked
+// at.  Within an exclusion group the highest priority due task runs and the
+// others keep their deadline so they are first in line next pass.
+void TaskScheduler::poll(const unsigned long now)
+{
+  int       dueIds[SCHED_MAX_TASKS];
+  int       nDue    = 0;
+  uint32_t  claimed = 0;   // Exclusion groups already used this pass
+  passes_++;
+  for (int i=0; i<n_; i++) tasks_[i].ready = false;
+  while ( size_>0 && (long)(now-tasks_[heap_[0]].due)>=0 ) dueIds[nDue++] = pop();
+  if ( nDue==0 )
+  {
+    idle_++;
+    return;
+  }
+
+  // Highest priority first; insertion sort is plenty for a dozen tasks
+  for (int i=1; i<nDue; i++)
+  {
+    int id = dueIds[i];
+    int j  = i-1;
+    while ( j>=0 && tasks_[dueIds[j]].priority<tasks_[id].priority )
+    {
+      dueIds[j+1] = dueIds[j];
+      j--;
+    }
+    dueIds[j+1] = id;
+  }
+
+  for (int i=0; i<nDue; i++)
+  {
+    int   id = dueIds[i];
+    Task *t  = &tasks_[id];
+    if ( t->group!=SCHED_FREE )
+    {
+      if ( claimed & (1UL<<t->group) )
+      {
+        t->skipped++;
+        push(id);
+        continue;
+      }
+      claimed |= (1UL<<t->group);
+    }
+    unsigned long jitter = now - t->due;
+    if ( jitter>t->maxJitter ) t->maxJitter = jitter;
+    if ( jitter>t->budget    ) t->late++;
+    t->runs++;
+    t->ready  = true;
+    prev_[id] = t->last;
+    t->last   = now;
+    t->due    = now + t->period;
+    push(id);
+  }
+}
+
+// Time until the earliest deadline, ms.  Zero if something is already due.
+unsigned long TaskScheduler::untilNext(const unsigned long now)
+{
+  if ( size_==0 ) return(0xFFFFFFFFUL);
+  long wait = (long)(tasks_[heap_[0]].due-now);
+  return(wait>0 ? (unsigned long)wait : 0UL);
+}
+
+// Move a task's next deadline to 'due', ms, sooner or later.   The heap is
+// rebuilt; a dozen pushes.
+void TaskScheduler::reschedule(const int id, const unsigned long due)
+{
+  if ( id<0 || id>=n_ ) return;
+  int ids[SCHED_MAX_TASKS];
+  int n = size_;
+  for (int i=0; i<n; i++) ids[i] = heap_[i];
+  tasks_[id].due = due;
+  size_ = 0;
+  for (int i=0; i<n; i++) push(ids[i]);
+}
+
+// Report per-task counts
+void TaskScheduler::print(void)
+{
+  Serial.printf("sched: passes=%lu idle=%lu\n", passes_, idle_);
+  for (int i=0; i<n_; i++)
+  {
+    Task *t = &tasks_[i];
+    Serial.printf("sched: %-8s runs=%lu late=%lu skipped=%lu maxJitter=%lu\n",
+      t->name, t->runs, t->late, t->skipped, t->maxJitter);
+  }
+}
+
+void TaskScheduler::resetStats(void)
+{
+  passes_ = 0;
+  idle_   = 0;
+  for (int i=0; i<n_; i++)
+  {
+    tasks_[i].runs      = 0;
+    tasks_[i].late      = 0;
+    tasks_[i].skipped   = 0;
+    tasks_[i].maxJitter = 0;
+  }
+}
+
+// Earlier deadline first, ties to higher priority.  Deadlines compared by
+// signed difference so millis() rollover is harmless.
+bool TaskScheduler::before(const int a, const int b)
+{
+  long diff = (long)(tasks_[a].due-tasks_[b].due);
+  if ( diff!=0 ) return(diff<0);
+  return(tasks_[a].priority>tasks_[b].priority);
+}
+
+void TaskScheduler::push(const int id)
+{
+  int i = size_++;
+  heap_[i] = id;
+  while ( i>0 )
+  {
+    int parent = (i-1)/2;
+    if ( !before(heap_[i], heap_[parent]) ) break;
+    int tmp = heap_[i]; heap_[i] = heap_[parent]; heap_[parent] = tmp;
+    i = parent;
+  }
+}
+
+int TaskScheduler::pop(void)
+{
+  int top  = heap_[0];
+  heap_[0] = heap_[--size_];
+  int i = 0;
+  while ( true )
+  {
+    int left  = 2*i+1;
+    int right = left+1;
+    int best  = i;
+    if ( left<size_  && before(heap_[left],  heap_[best]) ) best = left;
+    if ( right<size_ && before(heap_[right], heap_[best]) ) best = right;
+    if ( best==i ) break;
+    int tmp = heap_[i]; heap_[i] = heap_[best]; heap_[best] = tmp;
+    i = best;
+  }
+  return(top);
+}
@@ -0,0 +1,75 @@
+/***************************************************
+  A cooperative deadline scheduler for loop()
+
+  Tasks are registered once in setup() and kept in a min-heap ordered by
+  next deadline so each pass of loop() only examines work that is due.
+  Tasks sharing a non-zero exclusion group never run in the same pass; the
+  highest priority due task of the group wins and the rest stay due for
+  the next pass and are counted as skipped.   A task that knows when it
+  next has work can reschedule() itself rather than run every period.
+
+  Class code for embedded application.
+
+  04-Feb-2016   Dave Gutz   Created
+ ****************************************************/
+
+#ifndef _myScheduler_H
+#define _myScheduler_H
+
+#include "application.h"
+
+#define SCHED_MAX_TASKS   12                // Maximum number of registered tasks
+#define SCHED_FREE        0                 // Exclusion group that never excludes
+
+
+class Task
+{
+public:
+  Task();
+  const char*   name;       // Label for reports
+  unsigned long period;     // Time between runs, ms
+  uint8_t       priority;   // Larger wins within an exclusion group
+  unsigned long budget;     // Allowed start latency past deadline before counted late, ms
+  uint8_t       group;      // Exclusion group, SCHED_FREE for none
+  unsigned long due;        // Next deadline, ms
+  unsigned long last;       // Last start time, ms
+  unsigned long runs;       // Number of times run
+  unsigned long late;       // Runs started more than budget past deadline
+  unsigned long skipped;    // Passes lost to a higher priority task in same group
+  unsigned long maxJitter;  // Worst start latency past deadline, ms
+  bool          ready;      // Selected to run this pass
+};
+
+
+class TaskScheduler
+{
+public:
+  TaskScheduler();
+  int           add(const char* name, const unsigned long period, const uint8_t priority,
+                  const unsigned long budget, const uint8_t group, const unsigned long first);
+  void          poll(const unsigned long now);
+  bool          ready(const int id){return(tasks_[id].ready);};
+  unsigned long elapsed(const int id){return(tasks_[id].last-prev_[id]);};  // Between last two starts, ms
+  unsigned long untilNext(const unsigned long now);
+  void          reschedule(const int id, const unsigned long due);
+  unsigned long passes(){return(passes_);};
+  unsigned long idlePasses(){return(idle_);};
+  const Task&   task(const int id){return(tasks_[id]);};
+  int           count(){return(n_);};
+  void          print(void);
+  void          resetStats(void);
+protected:
+  bool          before(const int a, const int b);
+  void          push(const int id);
+  int           pop(void);
+  Task          tasks_[SCHED_MAX_TASKS];
+  unsigned long prev_[SCHED_MAX_TASKS];   // Start time of the run before last, ms
+  int           heap_[SCHED_MAX_TASKS];   // Task ids, earliest deadline first
+  int           n_;                       // Number of registered tasks
+  int           size_;                    // Number of tasks in heap
+  unsigned long passes_;                  // Calls to poll()
+  unsigned long idle_;                    // Calls to poll() with nothing due
+};
+
+
+#endif
@@ -0,0 +1,79 @@
+/***************************************************
+  Honeywell HumidIcon (HIH6130) humidity/temperature sensor driver
+
+  Class code for embedded application.
+
+  05-Feb-2016   Dave Gutz   Created
+ ****************************************************/
+#include "mySensor.h"
+#include "application.h"
+#include "math.h"
+
+// class HIH6130
+// constructors
+HIH6130::HIH6130()
+  : addr_(0x27), state_(IDLE), start_(0UL), status_(HIH_STALE), hum_(0), tempF_(0.0),
+  reads_(0UL), stale_(0UL), errors_(0UL), timeouts_(0UL){}
+HIH6130::HIH6130(const uint8_t addr)
+  : addr_(addr), state_(IDLE), start_(0UL), status_(HIH_STALE), hum_(0), tempF_(0.0),
+  reads_(0UL), stale_(0UL), errors_(0UL), timeouts_(0UL){}
+// functions
+// Trigger phase:  an empty write starts a measurement cycle.  Ignored while
+// a conversion is outstanding.   False if the device didn't acknowledge,
+// counted as an error;  nothing is converting then.
+bool HIH6130::trigger(const unsigned long now)
+{
+  if ( state_!=IDLE ) return(true);
+  Wire.beginTransmission(addr_);
+  if ( Wire.endTransmission()!=0 )
+  {
+    errors_++;
+    return(false);
+  }
+  start_  = now;
+  state_  = CONVERTING;
+  return(true);
+}
+
+// Fetch phase:  returns true when fresh data was accepted this call.
+// Nothing touches the bus until the conversion time has passed.
+bool HIH6130::poll(const unsigned long now)
+{
+  if ( state_!=CONVERTING || (now-start_)<HIH_CONVERT_MS ) return(false);
+  if ( Wire.requestFrom(addr_, (uint8_t)4)<4 )
+  {
+    while ( Wire.available() ) Wire.read();
+    errors_++;
+    state_ = IDLE;
+    return(false);
+  }
+  uint8_t b0  = Wire.read();
+  uint8_t b1  = Wire.read();
+  uint8_t b2  = Wire.read();
+  uint8_t b3  = Wire.read();
+  status_     = b0 >> 6;
+  if ( status_==HIH_STALE )
+  {
+    stale_++;
+    if ( (now-start_)>HIH_TIMEOUT_MS )
+    {
+      timeouts_++;
+      state_ = IDLE;
+    }
+    return(false);      // Still CONVERTING; retry next pass
+  }
+  state_ = IDLE;
+  if ( status_!=HIH_VALID )
+  {
+    errors_++;
+    return(false);
+  }
+
+  // Honeywell conversion
+  int rawHum  = ((b0 << 8) & 0x3f00) | b1;
+  int rawTemp = ((b2 << 6) & 0x3fc0) | (b3 >> 2);
+  hum_        = roundf(rawHum / 163.83);
+  tempF_      = (float(rawTemp)*165.0/16383.0 - 40.0)*1.8 + 32.0;
+  reads_++;
+  return(true);
+}
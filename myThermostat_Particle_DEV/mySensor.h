@@ -0,0 +1,60 @@
+/***************************************************
+  Honeywell HumidIcon (HIH6130) humidity/temperature sensor driver
+
+  Split-phase read so the ~40 ms conversion overlaps other loop() work:
+  trigger() sends the measurement request and poll() fetches the result
+  on a later pass once the conversion time has passed.  A fetch that
+  reports stale data is retried on the next pass rather than accepted.
+
+  Class code for embedded application.
+
+  05-Feb-2016   Dave Gutz   Created
+ ****************************************************/
+
+#ifndef _mySensor_H
+#define _mySensor_H
+
+#include "application.h"
+
+#define HIH_CONVERT_MS   40UL               // Data sheet measurement cycle, ms
+#define HIH_TIMEOUT_MS   250UL              // Give up on stale fetches after, ms
+
+// Status bits, top two bits of first byte
+#define HIH_VALID        0                  // Normal, fresh data
+#define HIH_STALE        1                  // Data already fetched or conversion not done
+#define HIH_COMMAND      2                  // Device in command mode
+#define HIH_DIAG         3                  // Diagnostic condition
+
+
+class HIH6130
+{
+public:
+  enum State {IDLE, CONVERTING};
+  HIH6130();
+  HIH6130(const uint8_t addr);
+  bool    trigger(const unsigned long now);
+  bool    poll(const unsigned long now);
+  bool    busy(void){return(state_!=IDLE);};
+  unsigned long due(void){return(start_+HIH_CONVERT_MS);};  // Conversion done, ms
+  int     status(void){return(status_);};
+  int     humidity(void){return(hum_);};     // Relative humidity, %
+  double  tempF(void){return(tempF_);};      // Temperature, F, uncalibrated
+  unsigned long reads(void){return(reads_);};
+  unsigned long stale(void){return(stale_);};
+  unsigned long errors(void){return(errors_);};
+  unsigned long timeouts(void){return(timeouts_);};
+protected:
+  uint8_t       addr_;      // Bus address
+  State         state_;     // Read phase
+  unsigned long start_;     // Time of trigger, ms
+  int           status_;    // Status bits of last fetch
+  int           hum_;       // Relative humidity, %
+  double        tempF_;     // Temperature, F
+  unsigned long reads_;     // Accepted fetches
+  unsigned long stale_;     // Fetches rejected as stale
+  unsigned long errors_;    // Trigger NACKs, short reads and command/diagnostic status
+  unsigned long timeouts_;  // Conversions abandoned after HIH_TIMEOUT_MS
+};
+
+
+#endif
@@ -1,5 +1,6 @@
 #include "application.h"
 #include "mySubs.h"
+#include "myPersist.h"
 #include "math.h"
 
 #ifndef NO_WEATHER_HOOK
@@ -14,8 +15,28 @@ extern const float            tempCh[7][NCH];
 extern  int                   verbose;
 #ifndef NO_WEATHER_HOOK
   extern bool                 weatherGood;          // webhook OAT lookup successful, T/F
+  extern WeatherQuery         weather;              // Webhook OAT request in progress
 #endif
 
+// Heat control law.   Simple on/off with hysteresis on the compensated temperature and
+// 5 update persistence for call change to help those with fat fingers (requirement 12).
+bool controlLaw(const bool call, const int set, const double tempComp, double *callCount)
+{
+    bool callRaw;
+    if ( call )
+    {
+        callRaw    = ( (float(set)+float(HYST))  > tempComp);
+    }
+    else
+    {
+        callRaw    = ( (float(set)-float(HYST))  > tempComp );
+    }
+    *callCount  += max(min((float(callRaw)-*callCount),  0.2), -0.2);
+    *callCount  =  max(min(*callCount,                    1.0),  0.0);
+    return *callCount >= 1.0;
+}
+
+
 // Convert time to decimal for easy lookup
 double decimalTime(unsigned long *currentTime, char* tempStr)
 {
@@ -56,16 +77,33 @@ double decimalTime(unsigned long *currentTime, char* tempStr)
 
 
 
-//Updates Weather Forecast Data
+//Updates Weather Forecast Data.  Starts the webhook request and returns; the
+//reply is picked up by gotWeatherData and weather.update() in loop().
 #ifndef NO_WEATHER_HOOK
 void getWeather()
 {
-  // Don't check if same hour
+  weather.request(millis());
+} //End of getWeather function
+#endif
+
+
+// WeatherQuery Class Functions
+#ifndef NO_WEATHER_HOOK
+// Constructors
+WeatherQuery::WeatherQuery(void)
+  : state_(IDLE), fresh_(false), sent_(0UL), latency_(0UL), maxLatency_(0UL), totalLatency_(0UL),
+  requests_(0UL), received_(0UL), timeouts_(0UL), late_(0UL)
+{}
+// Publish the event that triggers the webhook.  False if no request was made.
+bool WeatherQuery::request(const unsigned long now)
+{
+  // Don't check if same hour or already waiting
   if (Time.hour() == updateweatherhour)
   {
     if (verbose>2 && weatherGood) Serial.printf("Weather up to date, tempf=%f\n", tempf);
-    return;
+    return false;
   }
+  if (state_ == REQUESTED) return false;
 
   if (verbose>2)
   {
@@ -73,19 +111,34 @@ void getWeather()
     Serial.flush();
   }
   weatherGood = false;
-  // publish the event that will trigger our webhook
   Spark.publish("get_weather");
-
-  unsigned long wait = millis();
-  //wait for subscribe to kick in or 0.9 secs
-  while (!weatherGood && (millis() < wait + WEATHER_WAIT))
+  sent_   = now;
+  state_  = REQUESTED;
+  requests_++;
+  return true;
+}
+// Reply arrived; called from the subscription handler
+void WeatherQuery::complete(const unsigned long now)
+{
+  if (state_ == TIMED_OUT) late_++;
+  if (state_ == REQUESTED || state_ == TIMED_OUT)
   {
-    //Tells the core to check for incoming messages from partile cloud
-    Spark.process();
-    delay(50);
+    latency_       = now - sent_;
+    totalLatency_ += latency_;
+    maxLatency_    = max(maxLatency_, latency_);
+    received_++;
   }
-  if (!weatherGood)
+  state_ = RECEIVED;
+  fresh_ = true;
+  badWeatherCall = 0;
+}
+// Run every pass.  Times out a request and returns true once per reply.
+bool WeatherQuery::update(const unsigned long now)
+{
+  if (state_ == REQUESTED && (now - sent_) >= WEATHER_WAIT)
   {
+    state_ = TIMED_OUT;
+    timeouts_++;
     if (verbose>3) Serial.print("Weather update failed.  ");
     badWeatherCall++;
     if (badWeatherCall > 2)
@@ -95,11 +148,15 @@ void getWeather()
       badWeatherCall = 0;
     }
   }
-  else
-  {
-    badWeatherCall = 0;
-  }
-} //End of getWeather function
+  bool taken = fresh_;
+  fresh_     = false;
+  return taken;
+}
+void WeatherQuery::print(void)
+{
+  Serial.printf("weather: requests=%lu timeouts=%lu late=%lu latency=%lu mean=%7.1f max=%lu ms\n",
+    requests_, timeouts_, late_, latency_, meanLatency(), maxLatency_);
+}
 #endif
 
 // This function will get called when weather data comes in
@@ -134,6 +191,7 @@ void gotWeatherData(const char *name, const char *data)
       updateweatherhour = Time.hour();  // To check once per hour
     #endif
     tempf = atof(tempStr);
+    weather.complete(millis());
     if (verbose>2)
     {
       if (verbose<4) Serial.println("");
@@ -181,16 +239,76 @@ double  houseTrack(const bool RESET, const double duty, const double Ta_Sense,\
 // HouseHeat Class Functions
 // Constructors
 HouseHeat::HouseHeat()
-  :   name_(""), Ha_(0), Hc_(0), Hf_(0), Ho_(0), Rn_(0), Rx_(0), Tn_(0), Tx_(0)
-{}
+  :   name_(""), Ha_(0), Hc_(0), Hf_(0), Ho_(0), Rn_(0), Rx_(0), Tn_(0), Tx_(0), integ_(EULER), lastStep_(0)
+{
+  step_[0].T = step_[1].T = 0;
+}
 HouseHeat::HouseHeat(const String name, const double Ha, const double Hc, const double Hf, const double Ho, \
   const double Rn, const double Rx, const double Tn, const double Tx)
-  :   name_(name), Ha_(Ha), Hc_(Hc), Hf_(Hf), Ho_(Ho), Rn_(Rn), Rx_(Rx), Tn_(Tn), Tx_(Tx), sNoise_(0)
-{}
+  :   name_(name), Ha_(Ha), Hc_(Hc), Hf_(Hf), Ho_(Ho), Rn_(Rn), Rx_(Rx), sNoise_(0), Tn_(Tn), Tx_(Tx),
+  integ_(EULER), lastStep_(0)
+{
+  step_[0].T = step_[1].T = 0;
+}
 HouseHeat::HouseHeat(const String name, const double Ha, const double Hc, const double Hf, const double Ho, \
     const double Rn, const double Rx, const double Tn, const double Tx, const double sNoise)
-    :   name_(name), Ha_(Ha), Hc_(Hc), Hf_(Hf), Ho_(Ho), Rn_(Rn), Rx_(Rx), Tn_(Tn), Tx_(Tx), sNoise_(sNoise)
-  {}
+    :   name_(name), Ha_(Ha), Hc_(Hc), Hf_(Hf), Ho_(Ho), Rn_(Rn), Rx_(Rx), sNoise_(sNoise), Tn_(Tn), Tx_(Tx),
+    integ_(EULER), lastStep_(0)
+  {
+    step_[0].T = step_[1].T = 0;
+  }
+// Exact discretization of the model for update time T and duty.   With states
+// x = {Tw, Ta, Tc} and inputs w = {OAT*Ho, 0, duty*Tb*Hf + otherHeat}, dx/dt = A*x + w,
+// so over a step with w held, x(T) = Phi*x(0) + Gam*w with Phi = e^(A*T) and
+// Gam = integral of e^(A*t) dt over [0, T].   The OAT band only moves Tb, an input,
+// so one Phi and Gam serve every OAT.   Both come from their series at h = T/2^k,
+// small enough to converge in a few terms, doubled back up with
+// Phi(2h) = Phi(h)^2 and Gam(2h) = Gam(h) + Phi(h)*Gam(h).
+void HouseHeat::discretize_(Step* s, const double T, const double duty)
+{
+  double A[3][3] = {
+    {-(Ha_+Ho_),  Ha_,          0},
+    { Ha_,        -(Ha_+Hc_),   Hc_},
+    { 0,          Hc_,          -(Hc_+duty*Hf_)}};
+  double norm = 0;
+  for (int i=0; i<3; i++) norm = max(norm, fabs(A[i][0])+fabs(A[i][1])+fabs(A[i][2]));
+  int    k = 0;
+  double h = T;
+  while ( norm*h>0.5 && k<30 ) { h /= 2.0; k++; }
+  // Series:  Phi = sum (A*h)^n/n!,  Gam = h*sum (A*h)^n/(n+1)!
+  double term[3][3] = {{1, 0, 0}, {0, 1, 0}, {0, 0, 1}};
+  double next[3][3];
+  for (int i=0; i<3; i++) for (int j=0; j<3; j++)
+  {
+    s->Phi[i][j] = term[i][j];
+    s->Gam[i][j] = term[i][j]*h;
+  }
+  for (int n=1; n<=12; n++)
+  {
+    for (int i=0; i<3; i++) for (int j=0; j<3; j++)
+      next[i][j] = (A[i][0]*term[0][j] + A[i][1]*term[1][j] + A[i][2]*term[2][j])*h/double(n);
+    for (int i=0; i<3; i++) for (int j=0; j<3; j++)
+    {
+      term[i][j]    = next[i][j];
+      s->Phi[i][j] += term[i][j];
+      s->Gam[i][j] += term[i][j]*h/double(n+1);
+    }
+  }
+  // Double back up to T
+  for (int m=0; m<k; m++)
+  {
+    double P[3][3], G[3][3];
+    for (int i=0; i<3; i++) for (int j=0; j<3; j++)
+    {
+      P[i][j] = s->Phi[i][0]*s->Phi[0][j] + s->Phi[i][1]*s->Phi[1][j] + s->Phi[i][2]*s->Phi[2][j];
+      G[i][j] = s->Gam[i][j] + s->Phi[i][0]*s->Gam[0][j] + s->Phi[i][1]*s->Gam[1][j] + s->Phi[i][2]*s->Gam[2][j];
+    }
+    memcpy(s->Phi, P, sizeof(P));
+    memcpy(s->Gam, G, sizeof(G));
+  }
+  s->T    = T;
+  s->duty = duty;
+}
 // Calculate
 double HouseHeat::update(const bool RESET, const double T, const double temp, const double duty, \
   const double otherHeat, const double OAT)
@@ -216,15 +334,119 @@ double HouseHeat::update(const bool RESET, const double T, const double temp, co
     Serial.printf("%s:  dTw_dt=%7.3f, dTa_dt=%7.3f, dTc_dt=%7.3f\n", name_.c_str(), dTw_dt, dTa_dt, dTc_dt);
     Serial.printf("%s:  Tb=%7.3f, Tc=%7.3f, Ta=%7.3f, Tw=%7.3f, OAT=%7.3f\n", name_.c_str(), Tb, Tc_, Ta_, Tw_, OAT);
   }
-  // Integration (Euler Backward Difference)
-  Tw_  = min(max(Tw_+dTw_dt*T,  -40), 120);
-  Ta_  = min(max(Ta_+dTa_dt*T,  -40), 120);
-  Tc_  = min(max(Tc_+dTc_dt*T,  -40), 120);
-  Ta_Sense_ = Ta_ + sNoise_ * float(random(-10, 10))/10.0;
+  if ( integ_==EXACT )
+  {
+    // Integration (state transition)
+    Step* s = &step_[lastStep_];
+    if ( s->T!=T || s->duty!=duty )
+    {
+      lastStep_ = 1-lastStep_;
+      s = &step_[lastStep_];
+      if ( s->T!=T || s->duty!=duty ) discretize_(s, T, duty);
+    }
+    double x[3] = {Tw_, Ta_, Tc_};
+    double w[3] = {OAT*Ho_, 0, duty*Tb*Hf_ + otherHeat};
+    double y[3];
+    for (int i=0; i<3; i++)
+      y[i] = s->Phi[i][0]*x[0] + s->Phi[i][1]*x[1] + s->Phi[i][2]*x[2] + s->Gam[i][0]*w[0] + s->Gam[i][2]*w[2];
+    Tw_  = min(max(y[0], -40), 120);
+    Ta_  = min(max(y[1], -40), 120);
+    Tc_  = min(max(y[2], -40), 120);
+  }
+  else
+  {
+    // Integration (Euler Backward Difference)
+    Tw_  = min(max(Tw_+dTw_dt*T,  -40), 120);
+    Ta_  = min(max(Ta_+dTa_dt*T,  -40), 120);
+    Tc_  = min(max(Tc_+dTc_dt*T,  -40), 120);
+  }
+  Ta_Sense_ = sNoise_>0 ? Ta_ + sNoise_ * float(random(-10, 10))/10.0 : Ta_;
   return dTa_dt;
 }
 
 
+// SetpointArbiter Class Functions
+// Constructors
+SetpointArbiter::SetpointArbiter(void)
+  : started_(false), mode_(POT), set_(MINSET), held_(false), lastHold_(false), lastPot_(0),
+  lastWebDmd_(0), lastSchd_(0)
+{}
+// Scheduling logic
+// 1.  Pot has highest priority
+//     a.  Pot will not hold past next schedule change
+//     b.  Web change will override it
+// 2.  Web Blynk has next highest priority
+//     a.  Web will hold only if HOLD is on
+//     b.  Web will HOLD indefinitely.
+//     c.  When Web is HELD, all other inputs are ignored
+// 3.  Finally the schedule gets it's say
+//     a.  Holds last number until time at next change
+//
+// Notes:
+// i.  webDmd is transmitted by Blynk to Photon only when it changes
+// ii. webHold is transmitted periodically by Blynk to Photon
+bool SetpointArbiter::update(const bool checkPot, const int potValue, const int potDmd, const int webDmd,
+  const bool webHold, const int schdDmd, const bool tableErr)
+{
+    // Initialize scheduling logic - don't change on boot
+    if ( !started_ )
+    {
+        lastPot_    = potValue;
+        lastWebDmd_ = webDmd;
+        lastSchd_   = schdDmd;
+        started_    = true;
+    }
+
+    // If user has adjusted the potentiometer (overrides schedule until next schedule change)
+    // Use potValue for checking because it has more resolution than the integer potDmd
+    if ( abs(potValue-lastPot_)>16 && checkPot )  // adjust from 64 because my range is 1214 not 4095
+    {
+        mode_       = POT;
+        set_        = min(max(MINSET, potDmd), MAXSET);
+        held_       = false;  // allow the pot to override the web demands.  HELD allows web to override schd.
+        if (verbose>0) Serial.printf("Setpoint based on pot:  %d\n", set_);
+        lastPot_    = potValue;
+        return true;
+    }
+    //
+    // Otherwise if web Blynk has adjusted setpoint (overridden temporarily by pot, until next web adjust)
+    // The held construct ensures that temp setting latched in by HOLD in Blynk cannot be accidentally changed
+    // The webHold construct ensures that pushing HOLD in Blynk causes control to snap to the web demand
+    else if ( ((abs(webDmd-lastWebDmd_)>0)  & (!held_)) | (webHold & (webHold!=lastHold_)) )
+    {
+        mode_       = WEB;
+        set_        = min(max(MINSET, webDmd), MAXSET);
+        if (verbose>0) Serial.printf("Setpoint based on web:  %d\n", set_);
+        lastWebDmd_ = webDmd;
+        return true;
+    }
+    //
+    // Otherwise if schedule has adjusted setpoint (overridden temporarily by pot or web, until next schd adjust)
+    else if ( (abs(schdDmd-lastSchd_)>0) & (!held_) )
+    {
+        mode_       = SCHD;
+        lastSchd_   = schdDmd;
+        if (tableErr)
+        {
+            Serial.println("***Table error, ignoring****");
+            return false;
+        }
+        set_        = min(max(MINSET, schdDmd), MAXSET);
+        if (verbose>0) Serial.printf("Setpoint based on schedule:  %d\n", set_);
+        return true;
+    }
+    return false;
+}
+// Latch a web hold change.   True when the hold changed and should be saved.
+bool SetpointArbiter::holdChanged(const bool webHold)
+{
+    if ( webHold==lastHold_ ) return false;
+    lastHold_   = webHold;
+    held_       = webHold;
+    return true;
+}
+
+
 // Setup function to Load the saved settings so can resume after power failure
 // or software reflash.  Note:  flash may return nonsense such as for a brand
 // new Photon unit and we'll need some safe (furnace off) default values.
@@ -232,14 +454,13 @@ void loadTemperature(int *set, bool *webHold, int *webDmd, const int addr)
 {
     if (verbose>0) Serial.println("Loading and displaying temperature from flash");
     uint8_t values[4];
-    EEPROM.get(addr, values);
+    flashShadow.get(addr, values);
     //
     *set     = values[0];
     if ( (*set     > MAXSET  ) | (*set     < MINSET  ) ) *set     = MINSET;
     displayTemperature(*set);
     //
-    *webHold = values[1];
-    if ( (*webHold >    1    ) | (*webHold <    0    ) ) *webHold =  0;
+    *webHold = values[1]==1;                // Blank or corrupt is 0
     //
     *webDmd  = (int)values[2];
     if ( (*webDmd  > MAXSET  ) | (*webDmd  < MINSET  ) ) *webDmd  = MINSET;
@@ -253,8 +474,64 @@ void loadTemperature(int *set, bool *webHold, int *webDmd, const int addr)
     if ( (Ta_Obs  > MAXSET+1) | (Ta_Obs  < MINSET-1) ) Ta_Obs  = (MAXSET+MINSET)/2;
 }
 
+// ScheduleIndex Class Functions
+// Constructors
+ScheduleIndex::ScheduleIndex(void)
+  : hours_(NULL), temps_(NULL), n_(0)
+{}
+// Index sorted change times.   False, and find() disabled, if they aren't.
+bool ScheduleIndex::build(const float *hours, const float *temps, const int n)
+{
+  n_ = 0;
+  if ( n<1 || n>SCHD_MAX ) return(false);
+  for (int i=1; i<n; i++) if ( !(hours[i]>hours[i-1]) ) return(false);
+  int i = -1;
+  for (int b=0; b<SCHD_BUCKETS; b++)
+  {
+    float tb = float(b)*SCHD_BUCKET;
+    while ( i+1<n && hours[i+1]<tb ) i++;
+    bucket_[b] = i<0 ? 0xFF : uint8_t(i);
+  }
+  hours_  = hours;
+  temps_  = temps;
+  n_      = n;
+  return(true);
+}
+// Entry in effect at tim, hr in week, or -1 if not built
+int ScheduleIndex::find(const double tim) const
+{
+  if ( n_==0 ) return(-1);
+  if ( tim>=hours_[n_-1] ) return(n_-1);      // As the scan, at the last change exactly
+  int b = int(tim/SCHD_BUCKET);
+  b = max(min(b, SCHD_BUCKETS-1), 0);
+  int i = bucket_[b]==0xFF ? -1 : bucket_[b];
+  while ( i+1<n_ && tim>hours_[i+1] ) i++;
+  return(i<0 ? n_-1 : i);
+}
+// Hours from tim until the entry after find(tim) takes effect, or -1 if not built.
+// Zero at a change exactly, as the new entry takes effect just after.
+double ScheduleIndex::untilNext(const double tim) const
+{
+  int i = find(tim);
+  if ( i<0 ) return(-1);
+  if ( tim<hours_[0] ) return(hours_[0]-tim);
+  if ( i==n_-1 ) return(hours_[0]+7*24-tim);
+  return(max(hours_[i+1]-tim, 0.0));
+}
+ScheduleIndex schedIndex;
+
+
 // Lookup temp at time
 double lookupTemp(double tim)
+{
+    int i = schedIndex.find(tim);
+    if ( i<0 ) return(lookupTempScan(tim));
+    return (schedIndex.temp(i));
+}
+
+
+// Lookup temp at time by scanning the table, for when hourCh can't be indexed
+double lookupTempScan(double tim)
 {
     // tim is decimal hours in week, 0 = midnight Sunday
     int day = tim/24;  // Day known apriori
@@ -275,6 +552,7 @@ double lookupTemp(double tim)
             if ( !(tim>hourCh[day][num]) )
             {
                 i--;
+                if ( i<0 ) i = 7*NCH-1;   // At the first change exactly
                 day = i/NCH;
                 num = i-day*NCH;
                 break;
@@ -297,11 +575,11 @@ double recoveryTime(double OAT)
 // Save temperature setpoint to flash for next startup.   During power
 // failures the thermostat will reset to the condition it was in before
 // the power failure.   Filter initialized to sensed temperature (lose anticipation briefly
-// following recovery from power failure).
+// following recovery from power failure).   Goes to flash after a quiet time, see myPersist.h.
 void saveTemperature(const int set, const int webDmd, const int held, const int addr)
 {
     uint8_t values[4] = { (uint8_t)set, (uint8_t)held, (uint8_t)webDmd, (uint8_t)(roundf(Ta_Obs)) };
-    EEPROM.put(addr, values);
+    flashShadow.put(addr, values);
 }
 
 
@@ -322,6 +600,20 @@ double scheduledTemp(double hourDecimal, double recoTime, bool *reco)
     return tempSchd;
 }
 
+
+// Hours from hourDecimal until scheduledTemp() can next change for the same recoTime,
+// the sooner of the next change at hourDecimal and at the recovery shifted time.
+// -1 if the schedule isn't indexed and the caller must keep asking.
+double scheduleChange(double hourDecimal, double recoTime)
+{
+    double hourDecimalShift = hourDecimal + recoTime;
+    if ( hourDecimalShift >7*24 ) hourDecimalShift -= 7*24;
+    double untilSchd      = schedIndex.untilNext(hourDecimal);
+    double untilSchdShift = schedIndex.untilNext(hourDecimalShift);
+    if ( untilSchd<0 || untilSchdShift<0 ) return(-1);
+    return(min(untilSchd, untilSchdShift));
+}
+
 // Setup LEDs
 void setupMatrix(Adafruit_8x8matrix m)
 {
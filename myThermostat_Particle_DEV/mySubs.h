@@ -4,7 +4,6 @@
 #include "application.h"
 #include "pixmaps.h"
 #include "adafruit-led-backpack.h"
-#include "SparkIntervalTimer.h"
 #define NCH         4                       // Number of temp changes in daily sched (4)
 #define USE_DST     1                       // Whether to apply DST or not, 0 or 1
 #define GMT         -5                      // Enter time different to zulu (does not respect DST)
@@ -14,16 +13,48 @@
 #else
   #define FILTER_DELAY   5000UL             // In range of tau/4 - tau/3  * 1000, ms
 #endif
+#define MODEL_DELAY      5000UL             // Model wait, ms
+#define CONTROL_DELAY    4000UL             // Control law wait, ms
+#define RATE_TAU    40.0                    // Rate filter time constant, sec, ~1/5 observed home time constant
+#define RATE_KV     400                     // Rate gain, F/(F/sec)
+#define HYST        0.75                    // Heat control law hysteresis (0.75), F
 #define MINSET      50                      // Minimum setpoint allowed (50), F
 #define NOMSET      68                      // Nominal setpoint for modeling etc, F
 #define MAXSET      72                      // Maximum setpoint allowed (72), F
 #define WEATHER_WAIT     900UL              // Time to wait for weather webhook, ms
+#define SCHD_BUCKET 0.25                    // Schedule index bucket, hr
+#define SCHD_BUCKETS 672                    // Schedule index buckets, 7*24/SCHD_BUCKET
+#define SCHD_MAX    254                     // Most schedule entries the index holds
 
+// HouseHeat constants of this house, for setup() and the host tools
+#define HOUSE_HA    (1.61/86400)            // Air to wall constant, BTU/sec/F
+#define HOUSE_HC    (114./86400)            // Core to air constant, BTU/sec/F
+#define HOUSE_HF    (1.75/86400)            // Firing constant, BTU/sec/F
+#define HOUSE_HO    (283./86400)            // Wall to outside constant, BTU/sec/F
+#define HOUSE_RN    29                      // Reset curve OAT at Tn, F
+#define HOUSE_RX    69                      // Reset curve OAT at Tx, F
+#define HOUSE_TN    180                     // Reset curve boiler temp at Rn, F
+#define HOUSE_TX    120                     // Reset curve boiler temp at Rx, F
+#define HOUSE_HEAT  HOUSE_HA, HOUSE_HC, HOUSE_HF, HOUSE_HO, HOUSE_RN, HOUSE_RX, HOUSE_TN, HOUSE_TX
 
-// Embedded model class
+enum Mode {POT, WEB, SCHD};                 // To keep track of mode
+enum Integration {EULER, EXACT};            // HouseHeat integration method
+
+
+// Embedded model class.   EULER integrates with forward Euler and needs small T.
+// EXACT steps the linear model with its state transition matrix e^(A*T) and input
+// matrix, computed once per update time and duty, so any T is accurate.
 class HouseHeat
 {
 private:
+  struct Step
+  {
+    double T;           // Update time, s, 0 if empty
+    double duty;        // Heat duty
+    double Phi[3][3];   // State transition, e^(A*T)
+    double Gam[3][3];   // Input, integral of e^(A*t) over T
+  };
+  void   discretize_(Step* s, const double T, const double duty);
   String name_;     // Object name label
   double Ha_;       // Air to wall constant, BTU/sec/F
   double Hc_;       // Core to air constant, BTU/sec/F
@@ -38,6 +69,9 @@ private:
   double Tn_;       // Low boiler reset curve setpoint break, F
   double Tx_;       // High boiler reset curve setpoint break, F
   double Tw_;       // Outside wall temp, F
+  Integration integ_;   // Integration method
+  Step   step_[2];  // EXACT discretizations, usually duty 0 and 1
+  int    lastStep_; // Most recently used step_
 public:
   HouseHeat(void);
   HouseHeat(const String name, const double Ha, const double Hc, const double Hf, const double Ho, \
@@ -49,8 +83,94 @@ public:
   double Ta_Sense(void){return Ta_Sense_;};
   double Tc(void){return Tc_;};
   double Tw(void){return Tw_;};
+  void   integration(const Integration integ){integ_ = integ;};
+};
+
+// Asynchronous webhook weather request.  request() publishes the webhook event and
+// returns at once; the subscription handler completes it and update(), run every
+// pass, times it out after WEATHER_WAIT.  Latency and timeout counts are kept to
+// tune WEATHER_WAIT against what the webhook really does.
+class WeatherQuery
+{
+public:
+  enum State {IDLE, REQUESTED, RECEIVED, TIMED_OUT};
+  WeatherQuery(void);
+  bool    request(const unsigned long now);
+  void    complete(const unsigned long now);
+  bool    update(const unsigned long now);
+  State   state(void){return(state_);};
+  unsigned long latency(void){return(latency_);};
+  unsigned long maxLatency(void){return(maxLatency_);};
+  double  meanLatency(void){return(received_>0 ? double(totalLatency_)/double(received_) : 0.0);};
+  unsigned long requests(void){return(requests_);};
+  unsigned long timeouts(void){return(timeouts_);};
+  unsigned long lateReplies(void){return(late_);};
+  void    print(void);
+private:
+  State         state_;         // Request progress
+  bool          fresh_;         // Data received and not yet taken by update()
+  unsigned long sent_;          // Time request published, ms
+  unsigned long latency_;       // Last reply in-flight time, ms
+  unsigned long maxLatency_;    // Worst reply in-flight time, ms
+  unsigned long totalLatency_;  // Sum of reply in-flight times, ms
+  unsigned long requests_;      // Webhook events published
+  unsigned long received_;      // Replies received
+  unsigned long timeouts_;      // Requests that passed WEATHER_WAIT without reply
+  unsigned long late_;          // Replies that came after their timeout
+};
+
+// Setpoint arbitration, requirements 7 and 8.   The pot wins when it is the most recent
+// change, then the web unless a web hold is latched, then the schedule.   update() runs
+// every pass and returns true when a new setpoint was chosen; the caller displays and
+// saves it.   The first call only latches the present inputs so nothing changes on boot.
+class SetpointArbiter
+{
+public:
+  SetpointArbiter(void);
+  bool    update(const bool checkPot, const int potValue, const int potDmd, const int webDmd,
+            const bool webHold, const int schdDmd, const bool tableErr);
+  bool    holdChanged(const bool webHold);
+  Mode    mode(void){return(mode_);};
+  int     set(void){return(set_);};
+  bool    held(void){return(held_);};
+  int     lastWebDmd(void){return(lastWebDmd_);};
+private:
+  bool    started_;     // Inputs latched, T/F
+  Mode    mode_;        // Present control mode
+  int     set_;         // Selected setpoint, F
+  bool    held_;        // Web toggled permanent and acknowledged
+  bool    lastHold_;    // Past webHold
+  int     lastPot_;     // Pot raw value at last pot change
+  int     lastWebDmd_;  // Web demand at last web change, F
+  int     lastSchd_;    // Schedule demand at last schedule change, F
+};
+
+// Schedule lookup index.   build() takes the week's change times, hours from midnight
+// Sunday in order, i.e. ScheduleStore::hours(), and notes for each
+// SCHD_BUCKET of the week the entry in effect at its start.   find() starts there
+// and steps over the few changes inside the bucket, so it costs the same however
+// long the schedule.   An entry takes effect just after its time;  before the
+// first entry the last is in effect, wrapping from Saturday.   Until a valid
+// build(), find() returns -1 and lookupTemp() scans the table instead.   temps,
+// the setpoint after each change, may be NULL if only find() is wanted.
+// untilNext() is the time from tim to the next change, wrapping the week.
+class ScheduleIndex
+{
+public:
+  ScheduleIndex(void);
+  bool    build(const float *hours, const float *temps, const int n);
+  int     find(const double tim) const;
+  float   temp(const int i) const {return(temps_[i]);};
+  double  untilNext(const double tim) const;
+private:
+  const float*  hours_;               // Change times, hr in week
+  const float*  temps_;               // Setpoint after each change, F
+  int           n_;                   // Entries, 0 if not built
+  uint8_t       bucket_[SCHD_BUCKETS];  // Entry in effect at bucket start, 0xFF before the first
 };
+extern  ScheduleIndex schedIndex;   // Index of the active schedule, built in setup() and on edits
 
+bool    controlLaw(const bool call, const int set, const double tempComp, double *callCount);
 double  decimalTime(unsigned long *currentTime, char* tempStr);
 void    displayRandom(void);
 void    displayTemperature(int temp);
@@ -60,9 +180,11 @@ double  houseTrack(const bool RESET, const double duty, const double Ta_Sense,\
    const double Ta_Obs, const double T);
 void    loadTemperature(int *set, bool *webHold, int *webDmd, const int addr);
 double  lookupTemp(double tim);
+double  lookupTempScan(double tim);
 double  recoveryTime(double OAT);
 void    saveTemperature(const int set, const int webDmd, const int held, const int addr);
 double  scheduledTemp(double hourDecimal, double recoTime, bool *reco);
+double  scheduleChange(double hourDecimal, double recoTime);
 void    setupMatrix(Adafruit_8x8matrix m);
 String  tryExtractString(String str, const char* start, const char* end);
 
@@ -0,0 +1,181 @@
+// Packed binary status record, see myTelemetry.h
+#include "myTelemetry.h"
+
+static_assert(sizeof(TelemetryRecord)==TELEM_BYTES, "TelemetryRecord must pack to TELEM_BYTES");
+
+static const char b64[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+// Base64 of n bytes at p, with padding, terminated.   Returns characters written.
+int base64Encode(const uint8_t *p, const int n, char *out)
+{
+  int o = 0;
+  for (int i=0; i<n; i+=3)
+  {
+    uint32_t v = uint32_t(p[i])<<16;
+    if ( i+1<n ) v |= uint32_t(p[i+1])<<8;
+    if ( i+2<n ) v |= p[i+2];
+    out[o++] = b64[(v>>18) & 0x3F];
+    out[o++] = b64[(v>>12) & 0x3F];
+    out[o++] = i+1<n ? b64[(v>>6) & 0x3F] : '=';
+    out[o++] = i+2<n ? b64[v & 0x3F]      : '=';
+  }
+  out[o] = '\0';
+  return(o);
+}
+
+// Bytes of the base64 in[0..n) into p, at most max.   Returns bytes, or -1 if
+// in is not base64.
+int base64Decode(const char *in, const int n, uint8_t *p, const int max)
+{
+  uint32_t  v    = 0;
+  int       bits = 0;
+  int       o    = 0;
+  for (int i=0; i<n; i++)
+  {
+    char c = in[i];
+    int  d;
+    if      ( c>='A' && c<='Z' ) d = c-'A';
+    else if ( c>='a' && c<='z' ) d = c-'a'+26;
+    else if ( c>='0' && c<='9' ) d = c-'0'+52;
+    else if ( c=='+' ) d = 62;
+    else if ( c=='/' ) d = 63;
+    else if ( c=='=' ) break;
+    else return(-1);
+    v     = (v<<6) | d;
+    bits += 6;
+    if ( bits>=8 )
+    {
+      bits -= 8;
+      if ( o>=max ) return(-1);
+      p[o++] = (v>>bits) & 0xFF;
+    }
+  }
+  return(o);
+}
+
+// v/per rounded and held to int16
+int16_t telemInt16(const double v, const double per)
+{
+  double s = v/per;
+  s = s<0 ? s-0.5 : s+0.5;
+  return(int16_t(max(min(s, 32767.0), -32768.0)));
+}
+
+// Bytes of r in its version
+int telemBytes(const TelemetryRecord &r)
+{
+  return(r.version==1 ? TELEM_V1_BYTES : TELEM_BYTES);
+}
+
+// Event payload of r, at most TELEM_CHARS and a terminator
+int telemEncode(const TelemetryRecord &r, char *out)
+{
+  return(base64Encode((const uint8_t*)&r, telemBytes(r), out));
+}
+
+// Record from a payload, false if it is not one of a known version.   A
+// version 1 record gets an empty window.
+bool telemDecode(const char *in, const int n, TelemetryRecord *r)
+{
+  uint8_t buf[TELEM_BYTES];
+  int     got = base64Decode(in, n, buf, TELEM_BYTES);
+  if ( !((got==TELEM_BYTES && buf[0]==TELEM_VERSION) || (got==TELEM_V1_BYTES && buf[0]==1)) ) return(false);
+  memset(r, 0, TELEM_BYTES);
+  memcpy(r, buf, got);
+  return(true);
+}
+
+// The text status of r, as published before the binary record, and the window
+// as absolute min and max and standard deviation
+int telemText(const TelemetryRecord &r, char *buf, const int n)
+{
+  int m = snprintf(buf, n, "|%02u:%02u|CALL %d|SET %4.1f|TEMP %7.3f|TEMPC %7.3f|HUM %u|HELD %d|T %5.2f|POT %u|WEB %u|SCH %u|OAT %4.1f|TMOD %7.3f|REJH %6.3f|",
+    r.minute/60, r.minute%60, (r.flags & TELEM_CALL)!=0, r.set/100.0, r.temp/100.0, r.tempComp/100.0, r.hum,
+    (r.flags & TELEM_HELD)!=0, r.T/1000.0, r.pot, r.web, r.schd, r.oat/10.0, r.tmod/100.0, r.rejh/1000.0);
+  if ( r.version==1 || m<0 || m>=n ) return(m);
+  static const char*  name[TELEM_SIGNALS] = {"TEMP", "TEMPC", "TMOD", "REJH"};
+  const int16_t       mean[TELEM_SIGNALS] = {r.temp, r.tempComp, r.tmod, r.rejh};
+  m += snprintf(buf+m, n-m, "DUTY %4.2f|STARTS %u|", r.duty/double(TELEM_DUTY), r.starts);
+  for (int i=0; i<TELEM_SIGNALS && m<n; i++)
+  {
+    double per = i<3 ? 100.0 : 1000.0;
+    m += snprintf(buf+m, n-m, "%sLO %7.3f|%sHI %7.3f|%sSD %6.3f|", name[i], (mean[i]-r.lo[i])/per,
+      name[i], (mean[i]+r.hi[i])/per, name[i], r.sd[i]/per);
+  }
+  return(m);
+}
+
+// r differs from was in a state, a setting, or by more than a deadband.   The
+// clock and the control update time don't count.
+bool telemMoved(const TelemetryRecord &r, const TelemetryRecord &was)
+{
+  return( r.flags!=was.flags || r.set!=was.set || r.hum!=was.hum || r.pot!=was.pot || r.web!=was.web ||
+          r.schd!=was.schd || abs(r.temp-was.temp)>TELEM_DEAD_TEMP || abs(r.tempComp-was.tempComp)>TELEM_DEAD_TEMP ||
+          abs(r.tmod-was.tmod)>TELEM_DEAD_TEMP || abs(r.oat-was.oat)>TELEM_DEAD_OAT ||
+          abs(r.rejh-was.rejh)>TELEM_DEAD_REJH );
+}
+
+
+// WindowStats Class Functions
+void WindowStats::add(const double x)
+{
+  n_++;
+  double d  = x - mean_;
+  mean_    += d/n_;
+  m2_      += d*(x - mean_);
+  if ( n_==1 || x<lo_ ) lo_ = x;
+  if ( n_==1 || x>hi_ ) hi_ = x;
+}
+void WindowStats::reset(void)
+{
+  n_ = 0UL; mean_ = 0; m2_ = 0; lo_ = 0; hi_ = 0;
+}
+
+
+// TelemetryWindow Class Functions
+// Constructors
+TelemetryWindow::TelemetryWindow(void)
+  : starts_(0), last_(false)
+{}
+// Functions
+// The signals at a sensor read
+void TelemetryWindow::sample(const double temp, const double tempComp, const double tmod, const double rejh)
+{
+  sig_[0].add(temp);
+  sig_[1].add(tempComp);
+  sig_[2].add(tmod);
+  sig_[3].add(rejh);
+}
+// CALL at a control update
+void TelemetryWindow::control(const bool call)
+{
+  call_.add(call ? 1.0 : 0.0);
+  if ( call && !last_ ) starts_++;
+  last_ = call;
+}
+// Window of r, its signals as means.   With no samples r keeps the sample it has.
+void TelemetryWindow::fill(TelemetryRecord *r) const
+{
+  r->version  = TELEM_VERSION;
+  r->duty     = uint8_t(call_.n()>0 ? call_.mean()*TELEM_DUTY + 0.5 : ((r->flags & TELEM_CALL) ? TELEM_DUTY : 0));
+  r->starts   = uint8_t(min(starts_, 255U));
+  int16_t* mean[TELEM_SIGNALS] = {&r->temp, &r->tempComp, &r->tmod, &r->rejh};
+  for (int i=0; i<TELEM_SIGNALS; i++)
+  {
+    r->lo[i] = r->hi[i] = r->sd[i] = 0;
+    if ( sig_[i].n()==0 ) continue;
+    double per = i<3 ? 0.01 : 0.001;
+    *mean[i]  = telemInt16(sig_[i].mean(), per);
+    r->lo[i]  = uint8_t(max(min((*mean[i] - sig_[i].lo()/per) + 0.5, 255.0), 0.0));
+    r->hi[i]  = uint8_t(max(min((sig_[i].hi()/per - *mean[i]) + 0.5, 255.0), 0.0));
+    r->sd[i]  = uint8_t(min(sqrt(sig_[i].variance())/per + 0.5, 255.0));
+  }
+}
+// Start a window, after a publish.   The last CALL carries over so a call
+// running across the boundary isn't counted as begun again.
+void TelemetryWindow::reset(void)
+{
+  for (int i=0; i<TELEM_SIGNALS; i++) sig_[i].reset();
+  call_.reset();
+  starts_ = 0;
+}
@@ -0,0 +1,122 @@
+/***************************************************
+  Packed binary status record for the stat publish
+
+  TelemetryRecord carries the fields of the text status
+      |hh:mm|CALL %d|SET %4.1f|TEMP %7.3f|TEMPC %7.3f|HUM %d|HELD %d|T %5.2f|
+      POT %d|WEB %d|SCH %d|OAT %4.1f|TMOD %7.3f|REJH %6.3f|
+  as little-endian scaled integers in TELEM_BYTES, temperatures to 0.01 F,
+  plus RECO.   The first byte is TELEM_VERSION;  a later layout
+  gets a new version and decoders keep the old ones.   telemEncode() makes
+  the event payload, base64 with padding, 48 characters where the text is
+  about 150, and no float formatting.
+
+  Version 2 publishes the window since the last publish rather than the
+  sample at it.   TelemetryWindow takes every sample, O(1) each:  TEMP,
+  TEMPC, TMOD and REJH become their window means, with min, max and
+  standard deviation beside them as offsets in the same units, and CALL
+  gets its duty fraction and the heat calls begun, so short excursions
+  and heater cycling show in the record.   Version 1, the 22 byte sample
+  record, still decodes, with no window.   telemDecode() reverses it and
+  telemText() gives back the text form, for compatibility and the host.
+  telemMoved() says whether a record differs from the last published by
+  more than the TELEM_DEAD deadbands, for change-driven publishing.
+
+  Class code for embedded application.
+
+  19-Feb-2016   Dave Gutz   Created
+ ****************************************************/
+
+#ifndef _myTelemetry_H
+#define _myTelemetry_H
+
+#include "application.h"
+
+#define TELEM_VERSION   2                   // TelemetryRecord layout
+#define TELEM_BYTES     36                  // sizeof(TelemetryRecord)
+#define TELEM_V1_BYTES  22                  // Version 1, no window
+#define TELEM_SIGNALS   4                   // Windowed:  TEMP, TEMPC, TMOD, REJH
+#define TELEM_DUTY      200                 // Duty fraction scale
+#define TELEM_CHARS     (4*((TELEM_BYTES+2)/3))   // Encoded length, without the terminator
+
+#define TELEM_DEAD_TEMP 10                  // TEMP, TEMPC, TMOD change worth publishing, F/100
+#define TELEM_DEAD_OAT  5                   // OAT change worth publishing, F/10
+#define TELEM_DEAD_REJH 10                  // REJH change worth publishing, 1/1000
+
+#define TELEM_CALL      0x01                // TelemetryRecord flags
+#define TELEM_HELD      0x02
+#define TELEM_RECO      0x04
+
+
+// Status at a publish, scaled to integers
+struct TelemetryRecord
+{
+  uint8_t   version;    // TELEM_VERSION
+  uint8_t   flags;      // TELEM_CALL, TELEM_HELD, TELEM_RECO
+  uint16_t  minute;     // hh:mm, minute of day
+  int16_t   set;        // SET, callCount+set-HYST, F/100
+  int16_t   temp;       // TEMP, Ta_Sense, F/100
+  int16_t   tempComp;   // TEMPC, F/100
+  int16_t   tmod;       // TMOD, Ta_Obs, F/100
+  int16_t   oat;        // OAT, F/10
+  int16_t   rejh;       // REJH, rejectHeat*200, 1/1000
+  uint16_t  T;          // T, control update time, ms
+  uint8_t   hum;        // HUM, %
+  uint8_t   pot;        // POT, F
+  uint8_t   web;        // WEB, F
+  uint8_t   schd;       // SCH, F
+  // Version 2
+  uint8_t   duty;       // DUTY, CALL fraction of the window, 1/TELEM_DUTY
+  uint8_t   starts;     // STARTS, heat calls begun in the window
+  uint8_t   lo[TELEM_SIGNALS];  // Window mean - min, units of the signal
+  uint8_t   hi[TELEM_SIGNALS];  // Window max - mean
+  uint8_t   sd[TELEM_SIGNALS];  // Window standard deviation
+};
+
+
+// Running min, max, mean and variance, O(1) a sample (Welford)
+class WindowStats
+{
+public:
+  WindowStats(void){reset();};
+  void          add(const double x);
+  void          reset(void);
+  unsigned long n(void) const {return(n_);};
+  double        mean(void) const {return(mean_);};
+  double        lo(void) const {return(lo_);};
+  double        hi(void) const {return(hi_);};
+  double        variance(void) const {return(n_>1 ? m2_/(n_-1) : 0.0);};
+private:
+  unsigned long n_;       // Samples
+  double        mean_;
+  double        m2_;      // Sum of squared differences from the mean
+  double        lo_;      // Least
+  double        hi_;      // Greatest
+};
+
+
+// The published signals over one window
+class TelemetryWindow
+{
+public:
+  TelemetryWindow(void);
+  void          sample(const double temp, const double tempComp, const double tmod, const double rejh);
+  void          control(const bool call);
+  void          fill(TelemetryRecord *r) const;
+  void          reset(void);
+private:
+  WindowStats   sig_[TELEM_SIGNALS];  // TEMP, TEMPC, TMOD, REJH
+  WindowStats   call_;                // CALL, 0 or 1
+  unsigned      starts_;              // Heat calls begun
+  bool          last_;                // Last CALL
+};
+
+int     base64Encode(const uint8_t *p, const int n, char *out);
+int     base64Decode(const char *in, const int n, uint8_t *p, const int max);
+int16_t telemInt16(const double v, const double per);
+int     telemEncode(const TelemetryRecord &r, char *out);
+bool    telemDecode(const char *in, const int n, TelemetryRecord *r);
+int     telemText(const TelemetryRecord &r, char *buf, const int n);
+int     telemBytes(const TelemetryRecord &r);
+bool    telemMoved(const TelemetryRecord &r, const TelemetryRecord &was);
+
+#endif
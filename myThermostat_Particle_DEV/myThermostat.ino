@@ -29,20 +29,20 @@ SYSTEM_THREAD(ENABLED);                     // Make sure heat system code always
 //#define WEATHER_BUG                       // Turn on bad weather return for debugging
 //#define NO_BLYNK                          // Turn off Blynk functions.  Interact using Particle cloud
 //#define NO_PARTICLE                       // Turn off Particle cloud functions.  Interact using Blynk.
+//#define STAT_TEXT                         // Publish stat as the pipe delimited text, not base64 TelemetryRecord
 
 // Test feature usually commented
 //#define  FAKETIME                         // For simulating rapid time passing of schedule
 
 // Constants always defined
 #define BLYNK_TIMEOUT_MS 2000UL             // Network timeout in ms;  default provided in BlynkProtocol.h is 2000
-#define CONTROL_DELAY    4000UL             // Control law wait, ms
-#define MODEL_DELAY      5000UL             // Model wait, ms
+#define PROF_RESERVE     512                // Space to reserve for profiler summary publish, under the 622 of a variable
 #define PUBLISH_DELAY    30000UL            // Time between cloud updates (10000), ms
 #define READ_DELAY       5000UL             // Sensor read wait (5000, 100 for stress test), ms
 #define QUERY_DELAY      15000UL            // Web query wait (15000, 100 for stress test), ms
 #define DISPLAY_DELAY    300UL              // LED display scheduling frame time, ms
+#define SCHD_SLEEP_MAX   3600000UL          // Longest wait for a schedule change, bounds clock resync and DST, ms
 #define HEAT_PIN         A1                 // Heat relay output pin on Photon (A1)
-#define HYST             0.75               // Heat control law hysteresis (0.75), F
 #define LED_PIN          D7                 // Status LED
 #define MATRIX1_ADDR     0x70               // LED display matrix address
 #define MATRIX2_ADDR     0x71               // LED display matrix address
@@ -53,7 +53,17 @@ SYSTEM_THREAD(ENABLED);                     // Make sure heat system code always
 #define ONE_DAY_MILLIS   86400000           // Number of milliseconds in one day (24*60*60*1000)
 
 #include "mySubs.h"
+#include "myBus.h"
 #include "myFilters.h"
+#include "myLog.h"
+#include "myPersist.h"
+#include "myProfiler.h"
+#include "myChannels.h"
+#include "myPublish.h"
+#include "mySchedule.h"
+#include "myScheduler.h"
+#include "mySensor.h"
+#include "myTelemetry.h"
 #include "myAuth.h"
 /* This file myAuth.h is not in Git repository because it contains personal information.
 Make it yourself.   It should look like this, with your personal authorizations:
@@ -74,41 +84,78 @@ Make it yourself.   It should look like this, with your personal authorizations:
 using namespace std;
 
 // Global local variables
-enum                Mode {POT, WEB, SCHD};  // To keep track of mode
+enum                Group {FREE=SCHED_FREE, ONE_PASS}; // Scheduler exclusion groups
 bool                call            = false;// Heat demand to relay control
 double              callCount;              // Floating point of bool call for calculation
-Mode                controlMode     = POT;  // Present control mode
+SetpointArbiter     arbiter;                // Setpoint selection among pot, web and schedule
+int                 controlTask;            // Scheduler id of control law
 double              controlTime     = 0.0;  // Decimal time, hour
 uint8_t             displayCount    = 0;    // Display frame number to execute
+int                 displayTask;            // Scheduler id of LED display frames
 const   int         EEPROM_ADDR     = 1;  // Flash address
-bool                held            = false;// Web toggled permanent and acknowledged
+int                 filterTask;             // Scheduler id of rate filter
 String              hmString        = "00:00"; // time, hh:mm
 bool                hourChErr       = false;// Flag error in input, T/F
 HouseHeat*          house;                  // House model
 HouseHeat*          houseEmbMod;            // House embedded model
 int                 hum             = 0;    // Relative humidity integer value, %
 int                 I2C_Status      = 0;    // Bus status
-bool                lastHold        = false;// Web toggled permanent and acknowledged
+BusManager          bus;                    // Shared I2C bus, sensor first
+unsigned long       busErrors       = 0;    // Sensor bus errors the displays were resynced for
+volatile unsigned long dimPosted    = 0UL;  // Dim requests posted by onTimerDim(), its only writer
+volatile unsigned long dimCollisions = 0UL; // Of those, posted while a bus job was running
+unsigned long       dimServed       = 0UL;  // Dim requests loop() has caught up with
+unsigned long       dimRuns         = 0UL;  // Dim frames loop() has run
 unsigned long       lastSync     = millis();// Sync time occassionally.   Recommended by Particle.
+int                 modelTask;              // Scheduler id of embedded model
 #ifndef BARE_PHOTON
   Adafruit_8x8matrix   matrix1;             // Tens LED matrix
   Adafruit_8x8matrix   matrix2;             // Ones LED matrix
+  int                  matrix1Bus;          // Bus device id of matrix1
+  int                  matrix2Bus;          // Bus device id of matrix2
 #endif
 IntervalTimer       myTimerD;               // To dim display
 int                 numTimeouts     = 0;    // Number of Particle.connect() needed to unfreeze
 double              OAT             = 30;   // Outside air temperature, F
 int                 potDmd          = 0;    // Pot value, deg F
 int                 potValue        = 62;   // Dial raw value, F
+LoopProfiler        prof;                   // Loop stage timing
+#ifndef NO_PARTICLE
+  String            profStr("WAIT...");     // Profiler summary string
+#endif
+PublishEngine       pub;                    // Change-driven publishing
+#ifndef NO_BLYNK
+  int               pubPin[PUB_PINS];       // Publish channel of each Blynk virtual pin
+  int               pubBytes[PUB_PINS];     // Message size estimate of each
+  int               pubDecimals[PUB_PINS];  // Format of each, 0 int or a double
+#endif
+int                 pubStat;                // Publish channel of stat
+int                 pubUptime;              // Publish channel of Uptime
 char                publishString[40];      // For uptime recording
-RateLagExp*         rateFilter;             // Exponential rate lag filter
+int                 publishTask;            // Scheduler id of publish
+int                 queryTask;              // Scheduler id of OAT query
+int                 readTask;               // Scheduler id of sensor read
 bool                reco;                   // Indicator of recovering on cold days by shifting schedule
 double              rejectHeat      = 0.0;  // Adjustment to embedded  model to match sensor, F/sec
+TaskScheduler       sched;                  // Loop task scheduler
+ScheduleStore       schedStore(SCHD_ADDR);  // Active schedule, compiled or edited
+int                 schdTask;               // Scheduler id of schedule interrogation, due at its next change
+double              schdReco        = -1;   // Recovery time of the last interrogation, hr
+#ifndef BARE_PHOTON
+  HIH6130           sensor(TEMP_SENSOR);    // Humidity/temperature sensor
+  int               sensorBus;              // Bus device id of sensor
+  bool              sensorFresh     = false;// sensorFetch() accepted a sample
+#endif
 int                 schdDmd         = 62;   // Sched raw value, F
 int                 set             = 62;   // Selected sched, F
+RingLog             statLog;                // Status records kept while the cloud is away
+TelemetryWindow     statWindow;             // Published signals since the last stat publish
 #ifndef NO_PARTICLE
-  String            statStr("WAIT...");     // Status string
+  char              statStr[STAT_RESERVE] = "WAIT...";  // Status as published
 #endif
-const  double       tau             = 40.0; // Rate filter time constant, sec, ~1/5 observed home time constant
+constexpr double    tau             = RATE_TAU; // Rate filter time constant, sec
+constexpr RateLagExpCoeff<double> rateCoeff(float(FILTER_DELAY)/1000.0, tau);  // Computed at compile time
+RateLagExpT<double, VARIABLE_STEP> rateFilter(rateCoeff, -0.1, 0.1);      // Exponential rate lag filter
 double              Ta_Sense        = 65.0; // Sensed temp, F
 double              tempComp;               // Sensed compensated temp, F
 double              updateTime      = 0.0;  // Control law update time, sec
@@ -117,18 +164,20 @@ int                 webDmd          = 62;   // Web sched, F
 
 
 // Externals
-extern  double      Ta_Obs          = 62;   // Modeled air temp, F
-extern  double      tempf           = 30.0;
-extern  int         verbose         = 4;    // Debug, as much as you can tolerate
+double              Ta_Obs          = 62;   // Modeled air temp, F
+double              tempf           = 30.0;
+int                 verbose         = 4;    // Debug, as much as you can tolerate
 #ifndef NO_WEATHER_HOOK
-  extern bool       weatherGood   = false;  // webhook OAT lookup successful, T/F
+  bool              weatherGood   = false;  // webhook OAT lookup successful, T/F
+  WeatherQuery      weather;                // Webhook OAT request in progress
 #endif
 
 
-// Schedules
+// Schedules.   These are the defaults;  one edited through the SCHD function
+// or Blynk V21 is kept in flash and used instead, see mySchedule.h.
 // Time to trigger setting change
 // There must be NCH columns
-extern float hourCh[7][NCH] = {
+float hourCh[7][NCH] = {
     6, 8, 16, 22,   // Sun
     4, 7, 16, 22,   // Mon
     4, 7, 16, 22,   // Tue
@@ -152,6 +201,42 @@ extern const float tempCh[7][NCH] = {
 
 
 
+// Bus jobs, run by bus.run() in loop()
+#ifndef BARE_PHOTON
+// Start a sensor conversion
+bool sensorTrigger(void* arg)
+{
+  return(sensor.trigger(millis()));
+}
+
+// Fetch the converted sample, if it's done
+bool sensorFetch(void* arg)
+{
+  unsigned long errors = sensor.errors();
+  if ( sensor.poll(millis()) ) sensorFresh = true;
+  return(sensor.errors()==errors);
+}
+
+// Send an LED matrix what has changed of its settings and frame
+bool matrixFlush(void* arg)
+{
+  Adafruit_8x8matrix* m = (Adafruit_8x8matrix*)arg;
+  m->setBrightness(1);  // 1-15
+  m->blinkRate(0);      // 0-3
+  m->writeDisplay();
+  return(m->status()==0);
+}
+
+// Send an LED matrix all of its settings and frame
+bool matrixResync(void* arg)
+{
+  Adafruit_8x8matrix* m = (Adafruit_8x8matrix*)arg;
+  m->resync();
+  return(m->status()==0);
+}
+#endif
+
+
 // Put randomly placed activity pattern on LED display to preserve life.
 void displayRandom(void)
 {
@@ -168,22 +253,21 @@ void displayRandom(void)
     matrix2.setCursor(1, 0);
     matrix2.drawBitmap(0, 0, randomPlus(), 8, 8, LED_ON);
   }
-  matrix1.setBrightness(1);  // 1-15
-  matrix2.setBrightness(1);  // 1-15
-  matrix1.writeDisplay();
-  matrix2.writeDisplay();
+  bus.post(matrix1Bus, matrixFlush, &matrix1);
+  bus.post(matrix2Bus, matrixFlush, &matrix2);
 #endif
   // Reset clock
   myTimerD.resetPeriod_SIT(DIM_DELAY, hmSec);
 }
 
 
-// Handler for the display dimmer timer, called automatically
+// Handler for the display dimmer timer, called automatically in interrupt context.
+// Only posts the request:  loop() draws it, so the bus is never driven from here
+// in the middle of a sensor read or a display write.
 void onTimerDim(void)
 {
-#ifndef BARE_PHOTON
-  displayRandom();
-#endif
+  dimPosted++;
+  if ( bus.busy() ) dimCollisions++;
 }
 
 
@@ -195,18 +279,10 @@ void displayTemperature(int temp)
 #ifndef BARE_PHOTON
     char ones = abs(temp) % 10;
     char tens =(abs(temp) / 10) % 10;
-    matrix1.clear();
-    matrix1.setCursor(0, 0);
-    matrix1.write(tens + '0');
-    matrix1.setBrightness(1);  // 1-15
-    matrix1.blinkRate(0);      // 0-3
-    matrix1.writeDisplay();
-    matrix2.clear();
-    matrix2.setCursor(0, 0);
-    matrix2.write(ones + '0');
-    matrix2.setBrightness(1);  // 1-15
-    matrix2.blinkRate(0);      // 0-3
-    matrix2.writeDisplay();
+    matrix1.showChar(tens + '0');
+    bus.post(matrix1Bus, matrixFlush, &matrix1);
+    matrix2.showChar(ones + '0');
+    bus.post(matrix2Bus, matrixFlush, &matrix2);
 #endif
     // Reset clock
     myTimerD.resetPeriod_SIT(DIM_DELAY, hmSec);
@@ -222,18 +298,10 @@ void displayMessage(const String str)
 #ifndef BARE_PHOTON
     char first  = str[0];
     char second = str[1];
-    matrix1.clear();
-    matrix1.setCursor(0, 0);
-    matrix1.write(first);
-    matrix1.setBrightness(1);  // 1-15
-    matrix1.blinkRate(0);      // 0-3
-    matrix1.writeDisplay();
-    matrix2.clear();
-    matrix2.setCursor(0, 0);
-    matrix2.write(second);
-    matrix2.setBrightness(1);  // 1-15
-    matrix2.blinkRate(0);      // 0-3
-    matrix2.writeDisplay();
+    matrix1.showChar(first);
+    bus.post(matrix1Bus, matrixFlush, &matrix1);
+    matrix2.showChar(second);
+    bus.post(matrix2Bus, matrixFlush, &matrix2);
 #endif
     // Reset clock
     myTimerD.resetPeriod_SIT(DIM_DELAY, hmSec);
@@ -243,13 +311,13 @@ void displayMessage(const String str)
 int setSaveDisplayTemp(int t)
 {
     set = t;
-    switch(controlMode)
+    switch(arbiter.mode())
     {
         case POT:   displayTemperature(set); displayCount=0; break;
         case WEB:   break;
         case SCHD:  break;
     }
-    saveTemperature(set, webDmd, held, EEPROM_ADDR);
+    saveTemperature(set, webDmd, arbiter.held(), EEPROM_ADDR);
     return set;
 }
 
@@ -280,6 +348,20 @@ int particleSet(String command)
 }
 #endif
 
+#ifndef NO_BLYNK
+// Attach a Terminal or Text Input widget to the Virtual pin 21 IN in your Blynk app
+// - and edit the schedule, commands as mySchedule.h.   Takes effect next loop pass.
+BLYNK_WRITE(V21) {
+    schedStore.edit(param.asStr());
+}
+#endif
+#ifndef NO_PARTICLE
+int particleSchedule(String command)
+{
+  return schedStore.edit(command.c_str());
+}
+#endif
+
 #ifndef NO_BLYNK
 // Attach a switch widget to the Virtual pin 6 in your Blynk app - and demand continuous web control
 // Note:  there are separate virtual IN and OUT in Blynk.
@@ -303,6 +385,58 @@ int particleHold(String command)
 }
 #endif
 
+// Status for the offline log, as the stat publish
+LogRecord statRecord(void)
+{
+    LogRecord r;
+    r.time      = Time.now();
+    r.temp      = int16_t(roundf(Ta_Sense*100.0));
+    r.tempComp  = int16_t(roundf(tempComp*100.0));
+    r.tmod      = int16_t(roundf(Ta_Obs*100.0));
+    r.set       = uint8_t(set);
+    r.oat       = int8_t(max(min(roundf(OAT), 127.0f), -128.0f));
+    r.flags     = (call ? LOG_CALL : 0) | (arbiter.held() ? LOG_HELD : 0) | (reco ? LOG_RECO : 0);
+    return r;
+}
+
+// Status for the stat publish, scaled to integers, over the window since the last
+TelemetryRecord statTelemetry(void)
+{
+    TelemetryRecord r;
+    r.version   = TELEM_VERSION;
+    r.flags     = (call ? TELEM_CALL : 0) | (arbiter.held() ? TELEM_HELD : 0) | (reco ? TELEM_RECO : 0);
+    r.minute    = uint16_t(long(controlTime*60.0) % (24*60));
+    r.set       = telemInt16(callCount*1+set-HYST, 0.01);
+    r.temp      = telemInt16(Ta_Sense, 0.01);
+    r.tempComp  = telemInt16(tempComp, 0.01);
+    r.tmod      = telemInt16(Ta_Obs, 0.01);
+    r.oat       = telemInt16(OAT, 0.1);
+    r.rejh      = telemInt16(rejectHeat*200, 0.001);
+    r.T         = uint16_t(min(max(updateTime*1000.0+0.5, 0.0), 65535.0));
+    r.hum       = uint8_t(hum);
+    r.pot       = uint8_t(potDmd);
+    r.web       = uint8_t(arbiter.lastWebDmd());
+    r.schd      = uint8_t(schdDmd);
+    statWindow.fill(&r);                    // Window means and spreads in place of the samples
+    return r;
+}
+
+#ifndef NO_BLYNK
+// Blynk write of a number that moved past the deadband of its channel or went stale
+void blynkPub(const int pin, const double v)
+{
+    if ( !pub.offer(pubPin[pin], v, pubBytes[pin]) ) return;
+    if ( pubDecimals[pin]==0 ) Blynk.virtualWrite(pin, int(v));
+    else               Blynk.virtualWrite(pin, v);
+}
+#endif
+
+// Commit settings held in RAM before a controlled reset or firmware update
+void onShutdown(system_event_t event, int param)
+{
+  flashShadow.flush();
+}
+
 // Setup
 void setup()
 {
@@ -310,9 +444,13 @@ void setup()
   Serial.begin(9600);
   delay(2000); // Allow board to settle
   pinMode(LED_PIN, OUTPUT);               // sets pin as output
+  flashShadow.begin();                    // Settings flash read once, written after quiet
+  System.on(reset | firmware_update, onShutdown);
+  if ( statLog.begin()>0 && verbose>0 ) Serial.printf("%d status records waiting\n", statLog.pending());
   #ifndef NO_PARTICLE
-    statStr.reserve(STAT_RESERVE);
     Particle.variable("stat", statStr);
+    profStr.reserve(PROF_RESERVE);
+    Particle.variable("prof", profStr);
   #endif
   pinMode(HEAT_PIN,   OUTPUT);
   pinMode(POT_PIN,    INPUT);
@@ -323,13 +461,25 @@ void setup()
     matrix2.begin(MATRIX2_ADDR);
     setupMatrix(matrix1);
     setupMatrix(matrix2);
+    sensorBus   = bus.add("sensor",  TEMP_SENSOR,  BUS_SENSOR);
+    matrix1Bus  = bus.add("matrix1", MATRIX1_ADDR, BUS_DISPLAY);
+    matrix2Bus  = bus.add("matrix2", MATRIX2_ADDR, BUS_DISPLAY);
     setSaveDisplayTemp(0);            // Assure user reset happened
+    while ( bus.pending() ) bus.run(millis());
+    sensor.trigger(millis());         // First sample converts during the settle
     delay(2000);
+    if ( sensor.poll(millis()) )
+    {
+      hum       = sensor.humidity();
+      Ta_Sense  = sensor.tempF() + TEMPCAL;
+    }
+    I2C_Status  = sensor.status();
   #else
     delay(10);
   #endif
   loadTemperature(&set, &webHold, &webDmd, EEPROM_ADDR);
   myTimerD.begin(onTimerDim, DIM_DELAY, hmSec);
+  prof.begin();
 
   // Time schedule convert and check
   for (int day=0; day<7; day++)
@@ -344,6 +494,9 @@ void setup()
   {
       if (hourCh[day][num] >= hourCh[day][num+1]) hourChErr = true;
   }
+  if ( !hourChErr ) schedStore.defaults(&hourCh[0][0], &tempCh[0][0], 7*NCH);
+  if ( schedStore.load() && verbose>0 ) Serial.printf("Stored schedule, %d changes\n", schedStore.size());
+  hourChErr = !schedIndex.build(schedStore.hours(), schedStore.temps(), schedStore.size());
 
   // OAT
   // Lets listen for the hook response
@@ -352,17 +505,15 @@ void setup()
   #endif
 
   // Models
-  house       = new HouseHeat("house",    1.61/86400, 114./86400, 1.75/86400, 283./86400, 29, 69, 180, 120, 0.01);
-  houseEmbMod = new HouseHeat("embHouse", 1.61/86400, 114./86400, 1.75/86400, 283./86400, 29, 69, 180, 120);
-
-  // Rate filter
-  rateFilter  = new RateLagExp(float(FILTER_DELAY)/1000.0, tau, -0.1, 0.1);
+  house       = new HouseHeat("house",    HOUSE_HEAT, 0.01);
+  houseEmbMod = new HouseHeat("embHouse", HOUSE_HEAT);
 
   // Begin
   Particle.connect();
   #ifndef NO_PARTICLE
     Particle.function("HOLD", particleHold);
     Particle.function("SET",  particleSet);
+    Particle.function("SCHD", particleSchedule);
   #endif
   #ifndef NO_BLYNK
     Blynk.begin(blynkAuth.c_str());
@@ -372,6 +523,35 @@ void setup()
     Serial.flush();
     getWeather();
   #endif
+
+  // Loop tasks.   All but publish are due at once so the first passes initialize.  Only one ONE_PASS task
+  // runs each pass (requirement 13), highest priority first:  publish, read, query and schedule, display,
+  // control.   The schedule task reschedules itself for the next time its demand can change.
+  // Publish sends only what moved past its deadband or went stale, see myPublish.h.
+  unsigned long start = millis();
+  //                        name        period            pri budget ms         group     first due
+  filterTask  = sched.add("filter",   FILTER_DELAY,     0,  FILTER_DELAY/10,  FREE,     start);
+  modelTask   = sched.add("model",    MODEL_DELAY,      0,  MODEL_DELAY/10,   FREE,     start);
+  publishTask = sched.add("publish",  PUBLISH_DELAY,    5,  PUBLISH_DELAY/10, ONE_PASS, start+PUBLISH_DELAY*4);
+  readTask    = sched.add("read",     READ_DELAY,       4,  READ_DELAY/10,    ONE_PASS, start);
+  queryTask   = sched.add("query",    QUERY_DELAY,      3,  QUERY_DELAY/10,   ONE_PASS, start);
+  schdTask    = sched.add("schedule", SCHD_SLEEP_MAX,   3,  QUERY_DELAY/10,   ONE_PASS, start);
+  displayTask = sched.add("display",  DISPLAY_DELAY,    2,  DISPLAY_DELAY,    ONE_PASS, start);
+  controlTask = sched.add("control",  CONTROL_DELAY,    1,  CONTROL_DELAY/10, ONE_PASS, start);
+
+  // Published quantities, see myChannels.h
+  pubStat     = pub.add(0,    PUB_STAT_AGE, PUB_EVERY);   // Deadbands in telemMoved()
+  pubUptime   = pub.add(0,    PUB_SLOW_AGE, PUB_EVERY);   // Age only
+  #ifndef NO_BLYNK
+    for (int i=0; i<BLYNK_CHANNELS; i++)
+    {
+      const BlynkChannel& c = blynkChannels[i];
+      pubPin[c.pin]       = pub.add(c.deadband, c.maxAge, c.group);
+      pubBytes[c.pin]     = pubBlynkBytes(c.pin, c.decimals);
+      pubDecimals[c.pin]  = c.decimals;
+    }
+  #endif
+
   if (verbose>1) Serial.printf("End setup()\n");
 }
 
@@ -385,153 +565,182 @@ void loop()
     bool                    display;            // LED display sequence, T/F
     bool                    filter;             // Filter for temperature, T/F
     bool                    model;              // Run model, T/F
-    bool                    publishAny;         // Publish, T/F
-    bool                    publish1;           // Publish, T/F
-    bool                    publish2;           // Publish, T/F
-    bool                    publish3;           // Publish, T/F
-    bool                    publish4;           // Publish, T/F
-    bool                    query;              // Query schedule and OAT, T/F
+    bool                    publish;            // Publish, T/F
+    bool                    query;              // Query OAT, T/F
+    bool                    schedule;           // Interrogate schedule, T/F
     bool                    read;               // Read, T/F
     bool                    checkPot;            // Display to LED, T/F
-    const  double           Kv           = 400; // Rate gain, F/(F/sec)
-    const  double           Kei          = 2e-5;// Correction integral gain, (F/sec)/F
-    const  double           Kep          = 4;   // Correction proportional gain, F/F
-    const  double           Kf           = 1;   // Observer gain, F/(F/sec)
-    const  double           Ki           = 1e-5;// Observer integral gain, (duty/sec)/F
-    const  double           Kp           = 2;   // Observer proportional gain, (duty/sec)/F
-    static double           lastHour     = 0.0; // Past used time value,  hours
-    static unsigned long    lastControl  = 0UL; // Last control law time, ms
-    static unsigned long    lastDisplay  = 0UL; // Las display time, ms
-    static unsigned long    lastFilter   = 0UL; // Last filter time, ms
-    static unsigned long    lastModel    = 0UL; // Las model time, ms
-    static unsigned long    lastPublish1 = 0UL; // Last publish time, ms
-    static unsigned long    lastPublish2 = 0UL; // Last publish time, ms
-    static unsigned long    lastPublish3 = 0UL; // Last publish time, ms
-    static unsigned long    lastPublish4 = 0UL; // Last publish time, ms
-    static unsigned long    lastQuery    = 0UL; // Last read time, ms
-    static unsigned long    lastRead     = 0UL; // Last read time, ms
+    const  double           Kv           = RATE_KV; // Rate gain, F/(F/sec)
+    static unsigned long    lastLog      = 0UL; // Last offline status record, ms
+    static unsigned long    lastDrain    = 0UL; // Last offline status record delivered, ms
+    static TelemetryRecord  statSent;           // Status last published
     static int              RESET        = 1;   // Dynamic initialization flag, T/F
-    double                  TaRat_Obs;          // Modeled rate of change of temp, F/sec
+    static double           TaRat_Obs    = 0.0; // Modeled rate of change of temp, F/sec
     static double           TaRat_Sense;        // Rate of change of temp, F/sec
     static double           tFilter;            // Modeled temp, F
 
+    prof.enter(PROF_LOOP);
+
     // Sequencing
     #ifndef NO_BLYNK
+      prof.enter(PROF_BLYNK);
       Blynk.run();
+      prof.exit(PROF_BLYNK);
     #endif
     if (millis() - lastSync > ONE_DAY_MILLIS)
     {
       // Request time synchronization from the Particle Cloud once per day
       Particle.syncTime();
       lastSync = millis();
+      sched.reschedule(schdTask, now);          // Clock may have moved
     }
 
-    filter    = ((now-lastFilter)>=FILTER_DELAY) || RESET>0;
+    // Only due tasks are examined; exclusion and priority are resolved by the scheduler
+    sched.poll(now);
+
+    filter    = sched.ready(filterTask);
     if ( filter )
     {
-      tFilter     = float(now-lastFilter)/1000.0;
+      tFilter     = float(sched.elapsed(filterTask))/1000.0;
       if ( verbose > 3 ) Serial.printf("Filter update=%7.3f\n", tFilter);
-      lastFilter    = now;
     }
 
-    model     = ((now-lastModel)>=MODEL_DELAY) || RESET>0;
+    model     = sched.ready(modelTask);
     if ( model )
     {
-      if ( verbose > 3 ) Serial.printf("Model update=%7.3f\n", float(now-lastModel)/1000.0);
-      lastModel    = now;
+      if ( verbose > 3 ) Serial.printf("Model update=%7.3f\n", float(sched.elapsed(modelTask))/1000.0);
     }
 
-    publish1  = ((now-lastPublish1) >= PUBLISH_DELAY*4);
-    if ( publish1 ) lastPublish1  = now;
-
-    publish2  = ((now-lastPublish2) >= PUBLISH_DELAY*4)  && ((now-lastPublish1) >= PUBLISH_DELAY);
-    if ( publish2 ) lastPublish2  = now;
-
-    publish3  = ((now-lastPublish3) >= PUBLISH_DELAY*4)  && ((now-lastPublish1) >= PUBLISH_DELAY*2);
-    if ( publish3 ) lastPublish3  = now;
-
-    publish4  = ((now-lastPublish4) >= PUBLISH_DELAY*4)  && ((now-lastPublish1) >= PUBLISH_DELAY*3);
-    if ( publish4 ) lastPublish4  = now;
-
-    publishAny  = publish1 || publish2 || publish3 || publish4;
+    publish   = sched.ready(publishTask);
 
-    read    = ((now-lastRead) >= READ_DELAY || RESET>0) && !publishAny;
-    if ( read     ) lastRead      = now;
+    read      = sched.ready(readTask);
+    query     = sched.ready(queryTask);
+    schedule  = sched.ready(schdTask);
+    display   = sched.ready(displayTask);
 
-    query   = ((now-lastQuery)>= QUERY_DELAY) && !read;
-    if ( query    ) lastQuery     = now;
-
-    display   = ((now-lastDisplay) >= DISPLAY_DELAY) && !query;
-    if ( display ) lastDisplay    = now;
-
-    unsigned long deltaT = now - lastControl;
-    control = (deltaT >= CONTROL_DELAY) && !display;
+    control   = sched.ready(controlTask);
     if ( control  )
     {
-      updateTime    = float(deltaT)/1000.0 + float(numTimeouts)/100.0;
-      lastControl   = now;
+      updateTime    = float(sched.elapsed(controlTask))/1000.0 + float(numTimeouts)/100.0;
     }
 
-    checkPot   = !control && !query  && !read && !publishAny;
+    checkPot   = !control && !query  && !schedule && !read && !publish;
 
+    if ( query || schedule ) prof.enter(PROF_QUERY);
     #ifndef NO_WEATHER_HOOK
-      // Get OAT webhook
+      // Get OAT webhook.   The request completes on a later pass without holding up the loop.
       if ( query    )
       {
-        unsigned long           then = millis();     // Keep track of time
         getWeather();
-        unsigned long           now = millis();     // Keep track of time
-        if (verbose>0) Serial.printf("weather update=%f\n", float(now-then)/1000.0);
-        if ( weatherGood )
-        {
-          OAT = tempf;
-        }
+      }
+      if ( weather.update(millis()) )
+      {
+        if (verbose>0) Serial.printf("weather update=%f\n", float(weather.latency())/1000.0);
+        OAT = tempf;
         if (verbose>5) Serial.printf("OAT=%f at %s\n", OAT, hmString.c_str());
+        if ( recoveryTime(OAT)!=schdReco ) sched.reschedule(schdTask, millis());
       }
     #endif
 
-    // Read sensors
+    // Schedule edits take effect here and reach flash a few bytes a pass
+    if ( schedStore.poll() )
+    {
+        hourChErr = !schedIndex.build(schedStore.hours(), schedStore.temps(), schedStore.size());
+        sched.reschedule(schdTask, now);
+        if ( verbose>0 ) Serial.printf("Schedule edited, %d changes\n", schedStore.size());
+    }
+
+    // Interrogate schedule, at its own time to the second, then sleep until it can next
+    // change.   OAT moving the recovery or a clock resync wakes it sooner.
+    if ( schedule )
+    {
+        char    schdStr[8];
+        double  hourDecimal = decimalTime(&currentTime, schdStr);
+        double  recoTime    = recoveryTime(OAT);
+        schdDmd   = scheduledTemp(hourDecimal, recoTime, &reco);
+        schdReco  = recoTime;
+        double  change      = scheduleChange(hourDecimal, recoTime);
+        unsigned long wait  = SCHD_SLEEP_MAX;
+        if ( change<0 ) wait = QUERY_DELAY;     // Not indexed, keep asking
+        else if ( change*3600000.0<SCHD_SLEEP_MAX ) wait = (unsigned long)(change*3600000.0) + 1000UL;  // Just past, clock is in s
+        #ifdef FAKETIME
+          wait = QUERY_DELAY;
+        #endif
+        sched.reschedule(schdTask, now + wait);
+        if ( verbose>3 ) Serial.printf("schedule=%d next in %lu s\n", schdDmd, wait/1000);
+    }
+    if ( query || schedule ) prof.exit(PROF_QUERY);
+
+    // Read sensors.   Trigger a conversion here; it is fetched on a later pass
+    // once converted, so the loop never waits on the sensor.
+    bool fetch = read;
+    #ifndef BARE_PHOTON
+      fetch = fetch || sensor.busy();
+    #endif
+    if ( fetch ) prof.enter(PROF_READ);
     if ( read )
     {
         if ( verbose>4 ) Serial.printf("READ\n");
         #ifndef BARE_PHOTON
-          Wire.beginTransmission(TEMP_SENSOR);
-          Wire.endTransmission();
-          delay(40);
-          Wire.requestFrom(TEMP_SENSOR, 4);
-          Wire.write(byte(0));
-          uint8_t b   = Wire.read();
-          I2C_Status  = b >> 6;
-
-          // Honeywell conversion
-          int rawHum  = (b << 8) & 0x3f00;
-          rawHum      |=Wire.read();
-          hum         = roundf(rawHum / 163.83);
-          int rawTemp = (Wire.read() << 6) & 0x3fc0;
-          rawTemp     |=Wire.read() >> 2;
-          Ta_Sense        = (float(rawTemp)*165.0/16383.0 - 40.0)*1.8 + 32.0 + TEMPCAL; // convert to fahrenheit and calibrate
+          bus.post(sensorBus, sensorTrigger, NULL);
         #else
-          delay(41); // Usual I2C time
           if ( RESET>0 ) Ta_Sense = NOMSET;
           house->update(RESET, READ_DELAY/1000, Ta_Sense, double(call), 0.0, OAT);
           Ta_Sense    = house->Ta_Sense();
         #endif
     }
+    #ifndef BARE_PHOTON
+      // The bus:  the sensor's jobs first, then at most one display job, none as the
+      // conversion comes due
+      if ( sensor.busy() )
+      {
+        if ( (long)(millis()-sensor.due())>=0 ) bus.post(sensorBus, sensorFetch, NULL);
+        else bus.expect(sensorBus, sensor.due());
+      }
+      bus.run(millis());
+      if ( sensorFresh )
+      {
+        if ( verbose>4 ) Serial.printf("FETCH\n");
+        sensorFresh = false;
+        hum       = sensor.humidity();
+        Ta_Sense  = sensor.tempF() + TEMPCAL;   // calibrate
+        tempComp  = Ta_Sense + TaRat_Obs*Kv;
+        statWindow.sample(Ta_Sense, tempComp, Ta_Obs, rejectHeat*200);
+      }
+      I2C_Status  = sensor.status();            // Stale fetches stay pending and retry next pass
+      if ( sensor.errors()!=busErrors )         // The displays share the bus, may have missed commands
+      {
+        busErrors = sensor.errors();
+        bus.post(matrix1Bus, matrixResync, &matrix1);
+        bus.post(matrix2Bus, matrixResync, &matrix2);
+      }
+    #endif
+    if ( fetch ) prof.exit(PROF_READ);
     if ( model )
     {
+      prof.enter(PROF_MODEL);
       if ( verbose>4 ) Serial.printf("MODEL\n");
       rejectHeat = houseTrack(RESET, double(call), Ta_Sense,  Ta_Obs, MODEL_DELAY/1000);
       TaRat_Obs = houseEmbMod->update(RESET, MODEL_DELAY/1000, Ta_Sense, double(call), rejectHeat, OAT);
       Ta_Obs    = houseEmbMod->Ta();
+      prof.exit(PROF_MODEL);
     }
     if ( filter )
     {
+      prof.enter(PROF_FILTER);
       if ( verbose>4 ) Serial.printf("FILTER\n");
-      TaRat_Sense = rateFilter->calculate(Ta_Sense, RESET, tFilter);
-      if ( verbose > 4) Serial.printf("Ta_Sense=%f, RESET=%d, tFilter=%f a=%f b=%f c=%f rstate=%f lstate=%f rate=%f\n", Ta_Sense, RESET, tFilter, rateFilter->a(), rateFilter->b(), rateFilter->c(), rateFilter->rstate(), rateFilter->lstate(), TaRat_Sense );
+      TaRat_Sense = rateFilter.calculate(Ta_Sense, RESET, tFilter);
+      if ( verbose > 4) Serial.printf("Ta_Sense=%f, RESET=%d, tFilter=%f a=%f b=%f c=%f rstate=%f lstate=%f rate=%f\n", Ta_Sense, RESET, tFilter, rateFilter.a(), rateFilter.b(), rateFilter.c(), rateFilter.rstate(), rateFilter.lstate(), TaRat_Sense );
       RESET = 0;
+      prof.exit(PROF_FILTER);
     }
-    if ( read ) tempComp  = Ta_Sense + TaRat_Obs*Kv;
+    #ifdef BARE_PHOTON
+      if ( read )
+      {
+        tempComp  = Ta_Sense + TaRat_Obs*Kv;
+        statWindow.sample(Ta_Sense, tempComp, Ta_Obs, rejectHeat*200);
+      }
+    #endif
 
     // Interrogate pot; run fast for good tactile feedback
     // my pot puts out 2872 - 4088 observed using following
@@ -542,91 +751,27 @@ void loop()
     #endif
     potDmd      = roundf((float(potValue)-2872)/(4088-2872)*26+47);
 
-
-    // Interrogate schedule
-    if ( query    )
-    {
-        double recoTime = recoveryTime(OAT);
-        schdDmd = scheduledTemp(controlTime, recoTime, &reco);
-    }
-
-    // Scheduling logic
-    // 1.  Pot has highest priority
-    //     a.  Pot will not hold past next schedule change
-    //     b.  Web change will override it
-    // 2.  Web Blynk has next highest priority
-    //     a.  Web will hold only if HOLD is on
-    //     b.  Web will HOLD indefinitely.
-    //     c.  When Web is HELD, all other inputs are ignored
-    // 3.  Finally the schedule gets it's say
-    //     a.  Holds last number until time at next change
-    //
-    // Notes:
-    // i.  webDmd is transmitted by Blynk to Photon only when it changes
-    // ii. webHold is transmitted periodically by Blynk to Photon
-
-    // Initialize scheduling logic - don't change on boot
-    static int      lastChangedPot      = potValue;
-    static int      lastChangedWebDmd   = webDmd;
-    static int      lastChangedSched    = schdDmd;
-
-
-    // If user has adjusted the potentiometer (overrides schedule until next schedule change)
-    // Use potValue for checking because it has more resolution than the integer potDmd
-    if ( fabsf(potValue-lastChangedPot)>16 && checkPot )  // adjust from 64 because my range is 1214 not 4095
+    // Setpoint arbitration, see SetpointArbiter::update
+    if ( arbiter.update(checkPot, potValue, potDmd, webDmd, webHold, schdDmd, hourChErr) )
     {
-        controlMode     = POT;
-        int t = min(max(MINSET, potDmd), MAXSET);
-        setSaveDisplayTemp(t);
-        held = false;  // allow the pot to override the web demands.  HELD allows web to override schd.
-        if (verbose>0) Serial.printf("Setpoint based on pot:  %ld\n", t);
-        lastChangedPot = potValue;
+        setSaveDisplayTemp(arbiter.set());
     }
-    //
-    // Otherwise if web Blynk has adjusted setpoint (overridden temporarily by pot, until next web adjust)
-    // The held construct ensures that temp setting latched in by HOLD in Blynk cannot be accidentally changed
-    // The webHold construct ensures that pushing HOLD in Blynk causes control to snap to the web demand
-    else if ( ((abs(webDmd-lastChangedWebDmd)>0)  & (!held)) | (webHold & (webHold!=lastHold)) )
+    if ( arbiter.holdChanged(webHold) )
     {
-        controlMode     = WEB;
-        int t = min(max(MINSET, webDmd), MAXSET);
-        setSaveDisplayTemp(t);
-        if (verbose>0) Serial.printf("Setpoint based on web:  %ld\n", t);
-        lastChangedWebDmd   = webDmd;
-    }
-    //
-    // Otherwise if schedule has adjusted setpoint (overridden temporarily by pot or web, until next schd adjust)
-    else if ( (fabsf(schdDmd-lastChangedSched)>0) & (!held) )
-    {
-        controlMode     = SCHD;
-        int t = min(max(MINSET, schdDmd), MAXSET);
-        if (hourChErr)
-        {
-            Serial.println("***Table error, ignoring****");
-        }
-        else
-        {
-            setSaveDisplayTemp(t);
-            if (verbose>0) Serial.printf("Setpoint based on schedule:  %ld\n", t);
-        }
-        lastChangedSched = schdDmd;
-    }
-    if (webHold!=lastHold)
-    {
-        lastHold    = webHold;
-        held        = webHold;
-        saveTemperature(set, webDmd, held, EEPROM_ADDR);
+        saveTemperature(set, webDmd, arbiter.held(), EEPROM_ADDR);
     }
+    flashShadow.poll(now);
 
 
     // Display Sequencing
     // Run a different frame each time in here
     if ( display )
     {
+      prof.enter(PROF_DISPLAY);
       switch ( displayCount++ )
       {
-        case 0-10:
-          break;      // Hold.  Useful for freezing display after adjusting POT
+        default:
+          break;      // Hold, 0-10 and between.  Useful for freezing display after adjusting POT
         case 11:
           displayMessage("S=");
           break;
@@ -656,6 +801,16 @@ void loop()
           displayCount = 0;
           break;
         }
+      prof.exit(PROF_DISPLAY);
+    }
+
+    // Dim requests posted by the timer interrupt.   Any number posted since the
+    // last pass are one frame.
+    if ( dimPosted!=dimServed )
+    {
+      dimServed = dimPosted;
+      dimRuns++;
+      displayRandom();
     }
 
 
@@ -663,39 +818,72 @@ void loop()
     // dynamic logic when needed
     if ( control )
     {
+      prof.enter(PROF_CONTROL);
       if (verbose>4) Serial.printf("Control\n");
       char  tempStr[8];                           // time, hh:mm
       controlTime = decimalTime(&currentTime, tempStr);
-      lastHour    = controlTime;
       hmString    = String(tempStr);
-      bool callRaw;
-      if ( call )
-      {
-          callRaw    = ( (float(set)+float(HYST))  > tempComp);
-      }
-      else
-      {
-          callRaw    = ( (float(set)-float(HYST))  > tempComp );
-      }
-      // 5 update persistence for call change to help those with fat fingers
-      callCount   += max(min((float(callRaw)-callCount),  0.2), -0.2);
-      callCount   =  max(min(callCount,                   1.0),  0.0);
-      call        =  callCount >= 1.0;
+      call        = controlLaw(call, set, tempComp, &callCount);
+      statWindow.control(call);
       digitalWrite(HEAT_PIN, call);
       digitalWrite(LED_PIN,  call);
+      prof.exit(PROF_CONTROL);
     }
 
 
-    // Publish
-    if ( publish1 || publish2 || publish3 || publish4 )
+    // Publish what moved past its deadband or went stale
+    if ( publish )
     {
+      prof.enter(PROF_PUBLISH);
+      pub.poll(now);
+      bool  cycle = pub.group()==0;             // Once a PUBLISH_DELAY*PUB_GROUPS
+      TelemetryRecord stat = statTelemetry();
       char  tmpsStr[STAT_RESERVE];
-      sprintf(tmpsStr, "|%s|CALL %d|SET %4.1f|TEMP %7.3f|TEMPC %7.3f|HUM %d|HELD %d|T %5.2f|POT %d|WEB %d|SCH %d|OAT %4.1f|TMOD %7.3f|REJH %6.3f|\0", \
-      hmString.c_str(), call, callCount*1+set-HYST, Ta_Sense, tempComp, hum, held, updateTime, potDmd, lastChangedWebDmd, schdDmd, OAT, Ta_Obs, rejectHeat*200);
+      #ifndef STAT_TEXT
+        telemEncode(stat, tmpsStr);
+      #else
+        sprintf(tmpsStr, "|%s|CALL %d|SET %4.1f|TEMP %7.3f|TEMPC %7.3f|HUM %d|HELD %d|T %5.2f|POT %d|WEB %d|SCH %d|OAT %4.1f|TMOD %7.3f|REJH %6.3f|", \
+        hmString.c_str(), call, callCount*1+set-HYST, Ta_Sense, tempComp, hum, arbiter.held(), updateTime, potDmd, arbiter.lastWebDmd(), schdDmd, OAT, Ta_Obs, rejectHeat*200);
+      #endif
       #ifndef NO_PARTICLE
-        statStr = String(tmpsStr);
+        strcpy(statStr, tmpsStr);
+        if ( cycle )
+        {
+          char profSum[PROF_RESERVE];
+          prof.summary(profSum, PROF_RESERVE);
+          profStr = String(profSum);
+        }
+      #endif
+      #ifndef STAT_TEXT
+        if (verbose>1)
+        {
+          char  textStr[2*STAT_RESERVE];
+          telemText(stat, textStr, sizeof(textStr));
+          Serial.printf("%s %s\n", tmpsStr, textStr);
+        }
+      #else
+        if (verbose>1) Serial.println(tmpsStr);
+      #endif
+      if (verbose>2 && cycle) sched.print();
+      if (verbose>2 && cycle) Serial.printf("flash: puts=%lu commits=%lu avoided=%lu\n", \
+        flashShadow.puts(), flashShadow.commits(), flashShadow.avoided());
+      if (verbose>2 && cycle) Serial.printf("log: appended=%lu pending=%d dropped=%lu\n", \
+        statLog.appended(), statLog.pending(), statLog.dropped());
+      if (verbose>2 && cycle) Serial.printf("publish: %lu messages %6.0f bytes/hr, fixed groups %lu %6.0f bytes/hr\n", \
+        pub.messages(), pub.bytesPerHour(), pub.fixedMessages(), pub.fixedPerHour());
+      #ifndef BARE_PHOTON
+        if (verbose>2 && cycle) Serial.printf("display: flushes=%lu skipped=%lu bytes=%lu commands skipped=%lu\n", \
+          matrix1.flushes()+matrix2.flushes(), matrix1.flushesSkipped()+matrix2.flushesSkipped(), \
+          matrix1.bytesSent()+matrix2.bytesSent(), matrix1.commandsSkipped()+matrix2.commandsSkipped());
+      #endif
+      #ifndef BARE_PHOTON
+        if (verbose>2 && cycle) bus.print();
+      #endif
+      if (verbose>2 && cycle) Serial.printf("dim: posted=%lu run=%lu collisions avoided=%lu\n", \
+        dimPosted, dimRuns, dimCollisions);
+      #ifndef NO_WEATHER_HOOK
+        if (verbose>2 && cycle) weather.print();
       #endif
-      if (verbose>1) Serial.println(tmpsStr);
       if ( Particle.connected() )
       {
           unsigned nowSec = now/1000UL;
@@ -703,44 +891,36 @@ void loop()
           unsigned min = (nowSec%3600)/60;
           unsigned hours = (nowSec%86400)/3600;
           sprintf(publishString,"%u:%u:%u",hours,min,sec);
-          Spark.publish("Uptime",publishString);
-          Spark.publish("stat", tmpsStr);
+          if ( pub.offerChanged(pubStat, telemMoved(stat, statSent), pubCloudBytes("stat", tmpsStr)) )
+          {
+              Spark.publish("stat", tmpsStr);
+              statSent = stat;
+              statWindow.reset();
+          }
+          if ( pub.offerChanged(pubUptime, false, pubCloudBytes("Uptime", publishString)) )
+              Spark.publish("Uptime", publishString);
           #ifndef NO_BLYNK
-            if (publish1)
-            {
-              if (verbose>4) Serial.printf("Blynk write1\n");
-              Blynk.virtualWrite(V0,  call);
-              Blynk.virtualWrite(V2,  Ta_Sense);
-              Blynk.virtualWrite(V3,  hum);
-              Blynk.virtualWrite(V4,  tempComp);
-              Blynk.virtualWrite(V5,  held);
-            }
-            if (publish2)
-            {
-              if (verbose>4) Serial.printf("Blynk write2\n");
-              Blynk.virtualWrite(V7,  controlTime);
-              Blynk.virtualWrite(V8,  updateTime);
-              Blynk.virtualWrite(V9,  potDmd);
-              Blynk.virtualWrite(V10, lastChangedWebDmd);
-              Blynk.virtualWrite(V11, set);
-            }
-            if (publish3)
-            {
-              if (verbose>4) Serial.printf("Blynk write3\n");
-              Blynk.virtualWrite(V12, schdDmd);
-              Blynk.virtualWrite(V13, Ta_Sense);
-              Blynk.virtualWrite(V14, I2C_Status);
+            if (verbose>4) Serial.printf("Blynk write\n");
+            blynkPub(V0,  call);
+            blynkPub(V2,  Ta_Sense);
+            blynkPub(V3,  hum);
+            blynkPub(V4,  tempComp);
+            blynkPub(V5,  arbiter.held());
+            blynkPub(V7,  controlTime);
+            blynkPub(V8,  updateTime);
+            blynkPub(V9,  potDmd);
+            blynkPub(V10, arbiter.lastWebDmd());
+            blynkPub(V11, set);
+            blynkPub(V12, schdDmd);
+            blynkPub(V13, Ta_Sense);
+            blynkPub(V14, I2C_Status);
+            if ( pub.offer(pubPin[V15], controlTime*60.0, pubBytes[V15]) )
               Blynk.virtualWrite(V15, hmString);
-              Blynk.virtualWrite(V16, callCount*1+set-HYST);
-            }
-            if (publish4)
-            {
-              if (verbose>4) Serial.printf("Blynk write4\n");
-              Blynk.virtualWrite(V17, reco);
-              Blynk.virtualWrite(V18, OAT);
-              Blynk.virtualWrite(V19, Ta_Obs);
-              Blynk.virtualWrite(V20, rejectHeat*200);
-            }
+            blynkPub(V16, callCount*1+set-HYST);
+            blynkPub(V17, reco);
+            blynkPub(V18, OAT);
+            blynkPub(V19, Ta_Obs);
+            blynkPub(V20, rejectHeat*200);
           #endif
         }
         else
@@ -748,7 +928,30 @@ void loop()
           if (verbose>2) Serial.printf("Particle not connected....connecting\n");
           Particle.connect();
           numTimeouts++;
+          statWindow.reset();                   // The offline log keeps samples, not windows
+          if ( now-lastLog>=LOG_PERIOD )
+          {
+            statLog.append(statRecord());
+            lastLog = now;
+          }
+        }
+        prof.exit(PROF_PUBLISH);
+    }
+
+    // Deliver status logged while offline, oldest first, slowly enough for the cloud
+    if ( !publish && statLog.pending()>0 && now-lastDrain>=LOG_DRAIN && Particle.connected() )
+    {
+        prof.enter(PROF_PUBLISH);
+        LogRecord r;
+        if ( statLog.next(&r) )
+        {
+            char  logStr[STAT_RESERVE];
+            statLog.format(r, logStr, STAT_RESERVE);
+            if ( Spark.publish("statlog", logStr) ) statLog.sent();
         }
+        lastDrain = now;
+        prof.exit(PROF_PUBLISH);
     }
+    prof.exit(PROF_LOOP);
     if (verbose>5) Serial.printf("end loop()\n");
 }  // loop